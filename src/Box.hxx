@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include "stdxx/vector.hxx"
+
+// Inclusive range of voxel coordinates.
+struct Box {
+	stx::position3i min;
+	stx::position3i max;
+};
+
+
+
+// True if coords lies in [0, size) on every axis.
+inline bool in_size(const stx::position3i & coords, const stx::size3u & size) {
+	return coords.x >= 0 && static_cast<std::uint32_t>(coords.x) < size.x
+		&& coords.y >= 0 && static_cast<std::uint32_t>(coords.y) < size.y
+		&& coords.z >= 0 && static_cast<std::uint32_t>(coords.z) < size.z;
+}
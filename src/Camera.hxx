@@ -4,4 +4,6 @@
 struct Camera {
     stx::position3f position;
     stx::quatf rotation;
+    // Horizontal and vertical field of view in degrees.
+    float fov = 90.f;
 };
\ No newline at end of file
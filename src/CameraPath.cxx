@@ -0,0 +1,112 @@
+#include "CameraPath.hxx"
+#include <algorithm>
+#include <cmath>
+#include "angle.hxx"
+
+namespace {
+	// Plain Hamilton quaternion used to work out the relative rotation between two keyframes.
+	// stx::quatf is only ever built through from_axis_angle, so slerp is expressed as
+	// a rotation of the first keyframe by a fraction of the relative angle.
+	struct Quat {
+		float w, x, y, z;
+	};
+
+
+
+	Quat axis_angle(float x, float y, float z, float angle) {
+		const float s = std::sin(angle / 2.f);
+		return Quat{std::cos(angle / 2.f), x * s, y * s, z * s};
+	}
+
+
+
+	Quat operator*(const Quat & a, const Quat & b) {
+		return Quat{
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+		};
+	}
+
+
+
+	Quat conjugate(const Quat & q) {
+		return Quat{q.w, -q.x, -q.y, -q.z};
+	}
+
+
+
+	Quat euler_quat(const stx::vector3f & degrees) {
+		return axis_angle(1, 0, 0, deg_to_rad(degrees.x)) * axis_angle(0, 0, 1, deg_to_rad(degrees.z));
+	}
+
+
+
+	stx::quatf slerp(const stx::vector3f & from, const stx::vector3f & to, float t) {
+		Quat relative = conjugate(euler_quat(from)) * euler_quat(to);
+		// Take the short way around.
+		if(relative.w < 0) relative = Quat{-relative.w, -relative.x, -relative.y, -relative.z};
+		const float angle = 2.f * std::acos(std::min(relative.w, 1.f));
+		const float s = std::sin(angle / 2.f);
+		if(s < 1e-6f) return camera_rotation(from);
+		const stx::vector3f axis {relative.x / s, relative.y / s, relative.z / s};
+		return camera_rotation(from) * stx::quatf::from_axis_angle(axis, angle * t);
+	}
+
+
+
+	float lerp(float a, float b, float t) {
+		return a + (b - a) * t;
+	}
+}
+
+
+
+stx::quatf camera_rotation(const stx::vector3f & degrees) {
+	return stx::quatf::from_axis_angle(stx::vector3f{1,0,0}, deg_to_rad(degrees.x))
+	     * stx::quatf::from_axis_angle(stx::vector3f{0,0,1}, deg_to_rad(degrees.z));
+}
+
+
+
+bool CameraPath::animated() const {
+	return this->keyframes.size() > 1;
+}
+
+
+
+std::size_t CameraPath::frames() const {
+	if(!this->animated()) return 1;
+	return this->keyframes.back().frame + 1;
+}
+
+
+
+Camera CameraPath::operator()(std::size_t frame) const {
+	const auto next = std::upper_bound(
+		std::begin(this->keyframes), std::end(this->keyframes), frame,
+		[] (std::size_t frame, const CameraKeyframe & key) { return frame < key.frame; });
+
+	if(next == std::begin(this->keyframes) || next == std::end(this->keyframes)) {
+		const CameraKeyframe & key = next == std::end(this->keyframes) ? this->keyframes.back() : this->keyframes.front();
+		return Camera {
+			.position = key.position,
+			.rotation = camera_rotation(key.rotation),
+			.fov = key.fov,
+		};
+	}
+
+	const CameraKeyframe & a = *std::prev(next);
+	const CameraKeyframe & b = *next;
+	const float t = static_cast<float>(frame - a.frame) / static_cast<float>(b.frame - a.frame);
+	return Camera {
+		.position = stx::position3f{
+			lerp(a.position.x, b.position.x, t),
+			lerp(a.position.y, b.position.y, t),
+			lerp(a.position.z, b.position.z, t),
+		},
+		.rotation = slerp(a.rotation, b.rotation, t),
+		.fov = lerp(a.fov, b.fov, t),
+	};
+}
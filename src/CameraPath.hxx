@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include "stdxx/vector.hxx"
+#include "Camera.hxx"
+
+// Camera pose at a given frame. Rotation is stored as euler angles in degrees,
+// the same way manifest.json spells it.
+struct CameraKeyframe {
+	std::size_t frame = 0;
+	stx::position3f position;
+	stx::vector3f rotation;
+	float fov = 90.f;
+};
+
+
+
+// Keyframed camera animation. Positions and fov are interpolated linearly,
+// rotations are slerped. A path with a single keyframe is a still camera.
+struct CameraPath {
+	std::vector<CameraKeyframe> keyframes;
+
+	bool animated() const;
+	// Frames up to and including the last keyframe, 1 for a still camera.
+	std::size_t frames() const;
+	Camera operator()(std::size_t frame) const;
+};
+
+
+
+stx::quatf camera_rotation(const stx::vector3f & degrees);
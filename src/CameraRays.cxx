@@ -0,0 +1,24 @@
+#include "CameraRays.hxx"
+#include "stdxx/matrix.hxx"
+#include "angle.hxx"
+
+namespace {
+	stx::vector3f rotate(const stx::matrix4f & rotation, stx::vector3f v) {
+		return stx::dim_cast<3>(rotation * stx::dim_cast<4>(v));
+	}
+}
+
+
+
+CameraRays::CameraRays(const Camera & camera, stx::size2u resolution) {
+	const stx::matrix4f rotation = stx::matrix4f::from_quat(camera.rotation);
+	const stx::vector3f forward = rotate(rotation, stx::vector3f{0, 1,  0});
+	const stx::vector3f right   = rotate(rotation, stx::vector3f{1, 0,  0});
+	const stx::vector3f down    = rotate(rotation, stx::vector3f{0, 0, -1});
+	const float extent = std::tan(deg_to_rad(camera.fov) / 2.f);
+
+	this->origin = camera.position;
+	this->corner = forward - right * extent - down * extent;
+	this->delta_x = right * (2.f * extent / static_cast<float>(resolution.x));
+	this->delta_y = down  * (2.f * extent / static_cast<float>(resolution.y));
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "stdxx/vector.hxx"
+#include "Camera.hxx"
+
+// Primary ray directions of one frame.
+// The camera basis is rotated once per frame, the direction through (x, y) is then two multiply-adds away.
+struct CameraRays {
+	CameraRays(const Camera & camera, stx::size2u resolution);
+
+	stx::vector3f operator()(float x, float y) const {
+		return this->corner + this->delta_x * x + this->delta_y * y;
+	}
+
+	stx::position3f origin;
+	// Direction through the top left pixel corner.
+	stx::vector3f corner;
+	// Change of the direction per pixel.
+	stx::vector3f delta_x;
+	stx::vector3f delta_y;
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+// Linear float color used for shading.
+struct Color {
+    float r, g, b, a;
+};
+
+
+
+// Rec. 709 luminance of linear RGB.
+inline float luminance(float r, float g, float b) {
+    return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
@@ -0,0 +1,76 @@
+#include "DistanceField.hxx"
+#include <array>
+#include <algorithm>
+#include "Scene.hxx"
+
+namespace {
+	constexpr std::uint8_t max_distance = 255;
+
+
+
+	// Lowers distances[i] to one more than its nearest neighbour at i - sign * offset.
+	void relax(std::vector<std::uint8_t> & distances, std::size_t i, const std::array<std::ptrdiff_t, 13> & offsets, std::ptrdiff_t sign) {
+		if(distances[i] == 0) return;
+		std::uint8_t nearest = max_distance;
+		for(const std::ptrdiff_t offset : offsets) {
+			nearest = std::min(nearest, distances[static_cast<std::size_t>(static_cast<std::ptrdiff_t>(i) - sign * offset)]);
+		}
+		if(nearest < max_distance) {
+			distances[i] = std::min<std::uint8_t>(distances[i], nearest + 1);
+		}
+	}
+}
+
+
+
+// Two pass chamfer: the forward pass takes the 13 of the 26 neighbours that precede a voxel
+// in x, y, z order, the backward pass the other 13. With unit weights this is exact for Chebyshev distance.
+DistanceField::DistanceField(const Scene & scene)
+	: size{scene.size}
+	, distances(std::size_t{scene.size.x + 2} * (scene.size.y + 2) * (scene.size.z + 2), max_distance) {
+
+	for(std::uint32_t bz = 0; bz < scene.bricks.z; ++bz) {
+		for(std::uint32_t by = 0; by < scene.bricks.y; ++by) {
+			for(std::uint32_t bx = 0; bx < scene.bricks.x; ++bx) {
+				if(scene.brick_empty(bx, by, bz)) continue;
+				const std::uint32_t x_end = std::min((bx + 1) << Scene::brick_shift, this->size.x);
+				const std::uint32_t y_end = std::min((by + 1) << Scene::brick_shift, this->size.y);
+				const std::uint32_t z_end = std::min((bz + 1) << Scene::brick_shift, this->size.z);
+				for(std::uint32_t z = bz << Scene::brick_shift; z < z_end; ++z) {
+					for(std::uint32_t y = by << Scene::brick_shift; y < y_end; ++y) {
+						for(std::uint32_t x = bx << Scene::brick_shift; x < x_end; ++x) {
+							if(voxel::is_transparent(scene(x, y, z))) continue;
+							this->distances[this->index(x + 1, y + 1, z + 1)] = 0;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	const std::ptrdiff_t dx = 1;
+	const std::ptrdiff_t dy = this->size.x + 2;
+	const std::ptrdiff_t dz = dy * (this->size.y + 2);
+	const std::array<std::ptrdiff_t, 13> offsets {
+		dx,
+		dy - dx, dy, dy + dx,
+		dz - dy - dx, dz - dy, dz - dy + dx,
+		dz - dx,      dz,      dz + dx,
+		dz + dy - dx, dz + dy, dz + dy + dx,
+	};
+
+	for(std::uint32_t z = 1; z <= this->size.z; ++z) {
+		for(std::uint32_t y = 1; y <= this->size.y; ++y) {
+			for(std::uint32_t x = 1; x <= this->size.x; ++x) {
+				relax(this->distances, this->index(x, y, z), offsets, +1);
+			}
+		}
+	}
+	for(std::uint32_t z = this->size.z; z >= 1; --z) {
+		for(std::uint32_t y = this->size.y; y >= 1; --y) {
+			for(std::uint32_t x = this->size.x; x >= 1; --x) {
+				relax(this->distances, this->index(x, y, z), offsets, -1);
+			}
+		}
+	}
+}
@@ -0,0 +1,66 @@
+#include "Framebuffer.hxx"
+#include <cmath>
+#include <limits>
+#include "Color.hxx"
+
+Framebuffer::Framebuffer(stx::size2u resolution)
+	: resolution{resolution}
+	, sum(std::size_t{resolution.x} * resolution.y * 4, 0.f)
+	, sum_sq(std::size_t{resolution.x} * resolution.y, 0.f)
+	, samples(std::size_t{resolution.x} * resolution.y, 0) {}
+
+
+
+void Framebuffer::add(std::uint32_t x, std::uint32_t y, float r, float g, float b, float a, float sum_sq, std::uint32_t samples) {
+	const std::size_t i = std::size_t{y} * this->resolution.x + x;
+	this->sum[4 * i + 0] += r;
+	this->sum[4 * i + 1] += g;
+	this->sum[4 * i + 2] += b;
+	this->sum[4 * i + 3] += a;
+	this->sum_sq[i] += sum_sq;
+	this->samples[i] += samples;
+}
+
+
+
+float Framebuffer::error(const Tile & tile) const {
+	float max_error = 0;
+	for(std::uint32_t y = tile.y_begin; y < tile.y_end; ++y) {
+		for(std::uint32_t x = tile.x_begin; x < tile.x_end; ++x) {
+			const std::size_t i = std::size_t{y} * this->resolution.x + x;
+			const float n = static_cast<float>(this->samples[i]);
+			if(n < 2) return std::numeric_limits<float>::infinity();
+			const float mean = luminance(this->sum[4 * i + 0], this->sum[4 * i + 1], this->sum[4 * i + 2]) / n;
+			const float variance = std::max(this->sum_sq[i] / n - mean * mean, 0.f) * n / (n - 1);
+			max_error = std::max(max_error, std::sqrt(variance / n) / std::max(mean, 0.05f));
+		}
+	}
+	return max_error;
+}
+
+
+
+std::vector<std::uint8_t> Framebuffer::to_rgba8(Tonemap op, float exposure) const {
+	std::vector<std::uint8_t> data(this->samples.size() * 4);
+	for(std::size_t i = 0; i < this->samples.size(); ++i) {
+		const float weight = this->samples[i] ? exposure / static_cast<float>(this->samples[i]) : 0.f;
+		data[4 * i + 0] = static_cast<std::uint8_t>(tonemap(op, this->sum[4 * i + 0] * weight) * 255.f);
+		data[4 * i + 1] = static_cast<std::uint8_t>(tonemap(op, this->sum[4 * i + 1] * weight) * 255.f);
+		data[4 * i + 2] = static_cast<std::uint8_t>(tonemap(op, this->sum[4 * i + 2] * weight) * 255.f);
+		data[4 * i + 3] = 255;
+	}
+	return data;
+}
+
+
+
+std::vector<float> Framebuffer::to_rgba32f() const {
+	std::vector<float> data(this->sum.size());
+	for(std::size_t i = 0; i < this->samples.size(); ++i) {
+		const float weight = this->samples[i] ? 1.f / static_cast<float>(this->samples[i]) : 0.f;
+		for(std::size_t c = 0; c < 4; ++c) {
+			data[4 * i + c] = this->sum[4 * i + c] * weight;
+		}
+	}
+	return data;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "stdxx/vector.hxx"
+#include "Stats.hxx"
+#include "tonemap.hxx"
+#include "Tile.hxx"
+
+// Float RGBA accumulation buffer.
+// Every pixel keeps the sum of its samples, so passes can be added to it in any number.
+// Alpha is the coverage of the primary rays, lost rays add 0.
+// The squared luminance of every sample is summed as well to estimate the noise left in a pixel.
+struct Framebuffer {
+	Framebuffer(stx::size2u resolution);
+
+	void add(std::uint32_t x, std::uint32_t y, float r, float g, float b, float a, float sum_sq, std::uint32_t samples);
+
+	// Largest standard error of the mean luminance in the tile, relative to that luminance.
+	// Luminance below 0.05 counts as 0.05, so black pixels do not need endless samples.
+	float error(const Tile & tile) const;
+
+	// Averages every pixel, applies exposure and tonemap and quantizes it to RGBA8.
+	// Alpha stays opaque.
+	std::vector<std::uint8_t> to_rgba8(Tonemap op = Tonemap::clamp, float exposure = 1.f) const;
+
+	// Averages every pixel. Linear, unclamped RGBA.
+	std::vector<float> to_rgba32f() const;
+
+	stx::size2u resolution;
+	std::vector<float> sum;
+	std::vector<float> sum_sq;
+	std::vector<std::uint32_t> samples;
+	Stats stats;
+};
@@ -0,0 +1,101 @@
+#include "ImageWriter.hxx"
+#include <utility>
+#include <algorithm>
+#include "write_image.hxx"
+#include "stb/stb_image_write.h"
+
+ImageWriter::ImageWriter(std::size_t num_of_threads) {
+	for(std::size_t i = 0; i < std::max<std::size_t>(num_of_threads, 1); ++i) {
+		this->workers.emplace_back([this] { this->work(); });
+	}
+}
+
+
+
+ImageWriter::~ImageWriter() {
+	{
+		std::unique_lock lock{this->mutex};
+		this->idle.wait(lock, [&] { return this->jobs.empty() && this->writing.empty(); });
+		this->stopping = true;
+	}
+	this->wake.notify_all();
+	this->workers.clear();
+}
+
+
+
+void ImageWriter::push(std::filesystem::path path, Framebuffer frame, Tonemap op, float exposure, int png_level) {
+	{
+		std::unique_lock lock{this->mutex};
+		const auto queued = std::find_if(std::begin(this->jobs), std::end(this->jobs), [&] (const Job & job) {
+			return job.path == path;
+		});
+		if(queued != std::end(this->jobs)) {
+			*queued = Job{std::move(path), std::move(frame), op, exposure, png_level};
+			return;
+		}
+		this->idle.wait(lock, [&] { return this->jobs.size() < this->workers.size(); });
+		this->jobs.push_back(Job{std::move(path), std::move(frame), op, exposure, png_level});
+	}
+	this->wake.notify_one();
+}
+
+
+
+void ImageWriter::wait() {
+	std::unique_lock lock{this->mutex};
+	this->idle.wait(lock, [&] { return this->jobs.empty() && this->writing.empty(); });
+	if(this->error) std::rethrow_exception(std::exchange(this->error, nullptr));
+}
+
+
+
+void ImageWriter::work() {
+	while(true) {
+		std::optional<Job> job;
+		{
+			std::unique_lock lock{this->mutex};
+			auto next = std::end(this->jobs);
+			this->wake.wait(lock, [&] {
+				next = this->next_job();
+				return next != std::end(this->jobs) || (this->stopping && this->jobs.empty());
+			});
+			if(next == std::end(this->jobs)) return;
+			job.emplace(std::move(*next));
+			this->jobs.erase(next);
+			if(this->writing.empty()) {
+				this->png_level = job->png_level;
+				stbi_write_png_compression_level = job->png_level;
+			}
+			this->writing.push_back(job->path);
+		}
+		this->idle.notify_all();
+
+		try {
+			write_image(job->path, job->frame, job->op, job->exposure);
+		}
+		catch(...) {
+			std::lock_guard lock{this->mutex};
+			if(!this->error) this->error = std::current_exception();
+		}
+
+		{
+			std::lock_guard lock{this->mutex};
+			this->writing.erase(std::find(std::begin(this->writing), std::end(this->writing), job->path));
+		}
+		this->idle.notify_all();
+		// A job held back for this path may run now.
+		this->wake.notify_all();
+	}
+}
+
+
+
+std::deque<ImageWriter::Job>::iterator ImageWriter::next_job() {
+	if(this->jobs.empty()) return std::end(this->jobs);
+	if(!this->writing.empty() && this->jobs.front().png_level != this->png_level) return std::end(this->jobs);
+	return std::find_if(std::begin(this->jobs), std::end(this->jobs), [&] (const Job & job) {
+		if(!this->writing.empty() && job.png_level != this->png_level) return false;
+		return std::find(std::begin(this->writing), std::end(this->writing), job.path) == std::end(this->writing);
+	});
+}
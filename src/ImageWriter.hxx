@@ -0,0 +1,63 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <exception>
+#include <filesystem>
+#include <condition_variable>
+#include "Framebuffer.hxx"
+#include "tonemap.hxx"
+
+// Encodes and writes finished frames on its own threads, so the next render
+// does not wait for deflate. Several queued images are encoded in parallel.
+// Images for the same path are written one after the other in push order.
+// stb only has a global PNG compression level, so images pushed with different levels
+// are never encoded at the same time. The writer owns that global.
+class ImageWriter {
+public:
+	ImageWriter(std::size_t num_of_threads);
+	~ImageWriter();
+
+	ImageWriter(const ImageWriter &) = delete;
+	ImageWriter & operator=(const ImageWriter &) = delete;
+
+	// Queues a frame. Blocks while every thread already has an image waiting,
+	// which bounds the number of framebuffers held in memory.
+	// A frame for a path that is still queued replaces the queued one, so
+	// progressive previews never pile up behind a slow encoder.
+	// op and exposure apply to 8 bit formats, see write_image. png_level is the deflate effort 1 to 9.
+	void push(std::filesystem::path path, Framebuffer frame, Tonemap op, float exposure, int png_level);
+
+	// Blocks until every queued image is written.
+	// The first write error is rethrown here.
+	void wait();
+
+private:
+	struct Job {
+		std::filesystem::path path;
+		Framebuffer frame;
+		Tonemap op;
+		float exposure;
+		int png_level;
+	};
+
+	void work();
+	// First queued job whose path is not being written and whose png_level matches
+	// the running writes, or end. The oldest job's level takes over once the running writes are done.
+	std::deque<Job>::iterator next_job();
+
+	std::vector<std::jthread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable idle;
+	std::deque<Job> jobs;
+	std::exception_ptr error;
+	// Paths currently being written.
+	std::vector<std::filesystem::path> writing;
+	// PNG level of the running writes.
+	int png_level = 0;
+	bool stopping = false;
+};
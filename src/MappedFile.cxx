@@ -0,0 +1,39 @@
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "MappedFile.hxx"
+
+MappedFile::MappedFile(const std::filesystem::path & path) {
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) throw std::runtime_error{"Cannot open " + path.string()};
+
+	struct stat info;
+	if(::fstat(fd, &info) != 0) {
+		::close(fd);
+		throw std::runtime_error{"Cannot stat " + path.string()};
+	}
+	this->size = static_cast<std::size_t>(info.st_size);
+
+	if(this->size > 0) {
+		this->data = ::mmap(nullptr, this->size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	::close(fd);
+	if(this->data == MAP_FAILED) {
+		this->data = nullptr;
+		throw std::runtime_error{"Cannot map " + path.string()};
+	}
+}
+
+
+
+MappedFile::~MappedFile() {
+	if(this->data) ::munmap(this->data, this->size);
+}
+
+
+
+std::span<const std::byte> MappedFile::bytes() const {
+	return {static_cast<const std::byte *>(this->data), this->size};
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <span>
+#include <cstddef>
+#include <filesystem>
+
+// Read only memory mapping of a whole file.
+class MappedFile {
+public:
+	MappedFile(const std::filesystem::path & path);
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+
+	std::span<const std::byte> bytes() const;
+
+private:
+	void * data = nullptr;
+	std::size_t size = 0;
+};
@@ -0,0 +1,126 @@
+#include "Occupancy.hxx"
+#include "Scene.hxx"
+
+namespace {
+	constexpr std::int32_t shift_per_level = 2;
+
+
+
+	std::uint32_t blocks(std::uint32_t voxels, std::int32_t shift) {
+		return static_cast<std::uint32_t>((std::uint64_t{voxels} + (std::uint64_t{1} << shift) - 1) >> shift);
+	}
+}
+
+
+
+Occupancy::Occupancy(const Scene & scene)
+	: size{scene.size}
+	, levels{empty_levels(scene.size)} {
+
+	for(std::uint32_t bz = 0; bz < scene.bricks.z; ++bz) {
+		for(std::uint32_t by = 0; by < scene.bricks.y; ++by) {
+			for(std::uint32_t bx = 0; bx < scene.bricks.x; ++bx) {
+				if(scene.brick_empty(bx, by, bz)) continue;
+				this->add_brick(scene, bx, by, bz);
+			}
+		}
+	}
+}
+
+
+
+std::vector<Occupancy::Level> Occupancy::empty_levels(stx::size3u size) {
+	const std::uint64_t longest = std::max({size.x, size.y, size.z});
+	std::vector<Level> levels;
+	std::int32_t shift = shift_per_level;
+	while(true) {
+		const stx::size3u level_size {
+			blocks(size.x, shift),
+			blocks(size.y, shift),
+			blocks(size.z, shift),
+		};
+		const std::size_t count = std::size_t{level_size.x} * level_size.y * level_size.z;
+		levels.push_back(Level {
+			.shift = shift,
+			.size = level_size,
+			.bits = std::vector<std::uint64_t>((count + 63) / 64, 0),
+		});
+		if((std::uint64_t{1} << shift) >= longest) break;
+		shift += shift_per_level;
+	}
+	return levels;
+}
+
+
+
+Occupancy::Occupancy(stx::size3u size, std::vector<Level> levels)
+	: size{size}
+	, levels{std::move(levels)} {}
+
+
+
+void Occupancy::add_brick(const Scene & scene, std::uint32_t bx, std::uint32_t by, std::uint32_t bz) {
+	const std::uint32_t x_end = std::min((bx + 1) << Scene::brick_shift, this->size.x);
+	const std::uint32_t y_end = std::min((by + 1) << Scene::brick_shift, this->size.y);
+	const std::uint32_t z_end = std::min((bz + 1) << Scene::brick_shift, this->size.z);
+	for(std::uint32_t z = bz << Scene::brick_shift; z < z_end; ++z) {
+		for(std::uint32_t y = by << Scene::brick_shift; y < y_end; ++y) {
+			for(std::uint32_t x = bx << Scene::brick_shift; x < x_end; ++x) {
+				if(voxel::is_transparent(scene(x, y, z))) continue;
+				for(Level & level : this->levels) {
+					level.set(x >> level.shift, y >> level.shift, z >> level.shift);
+				}
+			}
+		}
+	}
+}
+
+
+
+std::optional<Box> Occupancy::empty_block(const stx::position3i & coords) const {
+	if(!in_size(coords, this->size)) return std::nullopt;
+
+	for(auto level = this->levels.rbegin(); level != this->levels.rend(); ++level) {
+		const std::uint32_t x = static_cast<std::uint32_t>(coords.x) >> level->shift;
+		const std::uint32_t y = static_cast<std::uint32_t>(coords.y) >> level->shift;
+		const std::uint32_t z = static_cast<std::uint32_t>(coords.z) >> level->shift;
+		if(level->test(x, y, z)) continue;
+		const std::int32_t edge = 1 << level->shift;
+		const stx::position3i min {
+			static_cast<std::int32_t>(x << level->shift),
+			static_cast<std::int32_t>(y << level->shift),
+			static_cast<std::int32_t>(z << level->shift),
+		};
+		return Box {
+			.min = min,
+			.max = {min.x + edge - 1, min.y + edge - 1, min.z + edge - 1},
+		};
+	}
+	return std::nullopt;
+}
+
+
+
+const std::vector<Occupancy::Level> & Occupancy::get_levels() const {
+	return this->levels;
+}
+
+
+
+std::size_t Occupancy::Level::index(std::uint32_t x, std::uint32_t y, std::uint32_t z) const {
+	return (std::size_t{z} * this->size.y + y) * this->size.x + x;
+}
+
+
+
+bool Occupancy::Level::test(std::uint32_t x, std::uint32_t y, std::uint32_t z) const {
+	const std::size_t i = this->index(x, y, z);
+	return (this->bits[i / 64] >> (i % 64)) & 1;
+}
+
+
+
+void Occupancy::Level::set(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+	const std::size_t i = this->index(x, y, z);
+	this->bits[i / 64] |= std::uint64_t{1} << (i % 64);
+}
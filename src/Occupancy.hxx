@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <optional>
+#include "stdxx/vector.hxx"
+#include "Box.hxx"
+
+struct Scene;
+
+// Hierarchical bitmask over the opaque voxels of a scene.
+// Level 0 stores one bit per 4x4x4 block, every further level groups 4x4x4 blocks of the level below.
+class Occupancy {
+public:
+	struct Level {
+		std::int32_t shift;
+		stx::size3u size;
+		std::vector<std::uint64_t> bits;
+
+		std::size_t index(std::uint32_t x, std::uint32_t y, std::uint32_t z) const;
+		bool test(std::uint32_t x, std::uint32_t y, std::uint32_t z) const;
+		void set(std::uint32_t x, std::uint32_t y, std::uint32_t z);
+	};
+
+	Occupancy() = default;
+	Occupancy(const Scene & scene);
+	Occupancy(stx::size3u size, std::vector<Level> levels);
+
+	// Levels of a scene of the given size with all bits cleared.
+	// Scene files are checked against this layout.
+	static std::vector<Level> empty_levels(stx::size3u size);
+
+	// Largest empty block containing coords or nothing if coords lies in an occupied 4x4x4 block.
+	std::optional<Box> empty_block(const stx::position3i & coords) const;
+
+	const std::vector<Level> & get_levels() const;
+
+private:
+
+	void add_brick(const Scene & scene, std::uint32_t bx, std::uint32_t by, std::uint32_t bz);
+
+	stx::size3u size;
+	std::vector<Level> levels;
+};
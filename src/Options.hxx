@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include "tonemap.hxx"
+
+enum class Integrator {
+	recursive,
+	path,
+};
+
+struct Options {
+	bool quiet = false;
+	std::size_t threads = 1;
+	std::size_t tile_size = 32;
+	// Primary rays cast together. 1 selects the scalar ray_cast.
+	std::size_t packet_size = 1;
+	std::size_t samples = 1;
+	// Depth of the bounce tree. split is the number of bounces spawned at the first hit.
+	std::size_t max_bounce = 4;
+	std::size_t split = 3;
+	// Rays passing this distance count as lost.
+	float max_distance = 100.f;
+	std::uint64_t seed = 0;
+	Integrator integrator = Integrator::recursive;
+	// Renders one sample per pass and writes the image in between.
+	// options.samples is the target, time_budget in seconds stops earlier if > 0.
+	// A time budget without progressive renders in passes as well, but only writes the final image.
+	bool progressive = false;
+	double time_budget = 0;
+	double flush_interval = 1;
+	std::size_t flush_passes = 0;
+	// Relative noise at which a tile stops receiving samples. 0 samples every tile options.samples times.
+	float adaptive_threshold = 0;
+	std::size_t adaptive_min_samples = 8;
+	// Applied to 8 bit outputs only.
+	Tonemap tonemap = Tonemap::clamp;
+	float exposure = 1.f;
+	// stb deflate effort, 1 is fastest. Only affects .png output.
+	int png_level = 8;
+	// Threads encoding and writing finished images while the next one renders.
+	std::size_t encode_threads = 2;
+	// Projects kept loaded by --server.
+	std::size_t cache_size = 4;
+};
@@ -0,0 +1,51 @@
+#include "Progress.hxx"
+#include <sstream>
+#include <iomanip>
+#include "stdxx/log.hxx"
+
+Progress::Progress(std::size_t total_tiles, std::chrono::duration<double> interval)
+	: total_tiles{total_tiles}
+	, interval{interval}
+	, start{clock::now()}
+	, reporter{[this] (std::stop_token stop) { this->report(stop); }} {}
+
+
+
+Progress::~Progress() {
+	this->reporter.request_stop();
+	this->reporter.join();
+	this->log();
+}
+
+
+
+void Progress::report(std::stop_token stop) {
+	std::unique_lock lock{this->mutex};
+	while(true) {
+		// Only a stop request wakes the reporter early.
+		this->wake.wait_for(lock, stop, this->interval, [] { return false; });
+		if(stop.stop_requested()) return;
+		this->log();
+	}
+}
+
+
+
+void Progress::log() const {
+	const std::uint64_t tiles = this->tiles_done.load(std::memory_order_relaxed);
+	const std::uint64_t rays = this->rays_done.load(std::memory_order_relaxed);
+	const double seconds = std::chrono::duration<double>(clock::now() - this->start).count();
+	const double percent = this->total_tiles ? 100.0 * static_cast<double>(tiles) / static_cast<double>(this->total_tiles) : 100.0;
+	const double tiles_per_sec = seconds > 0 ? static_cast<double>(tiles) / seconds : 0.0;
+	const double rays_per_sec = seconds > 0 ? static_cast<double>(rays) / seconds : 0.0;
+
+	std::ostringstream line;
+	line << std::fixed << std::setprecision(1);
+	line << static_cast<int>(percent) << "% of tiles done, "
+	     << tiles_per_sec << " tiles/s, "
+	     << rays_per_sec / 1e6 << " Mrays/s (primary)";
+	if(tiles > 0 && tiles < this->total_tiles) {
+		line << ", ETA " << seconds * static_cast<double>(this->total_tiles - tiles) / static_cast<double>(tiles) << "s";
+	}
+	stx::log[stx::INFO] << line.str();
+}
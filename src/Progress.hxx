@@ -0,0 +1,40 @@
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <condition_variable>
+
+// Progress of a render pass.
+// Workers only bump relaxed atomic counters. A reporter thread logs progress,
+// tile rate, primary rays per second and the estimated time left at a fixed interval.
+class Progress {
+public:
+	Progress(std::size_t total_tiles, std::chrono::duration<double> interval);
+	~Progress();
+
+	Progress(const Progress &) = delete;
+	Progress & operator=(const Progress &) = delete;
+
+	void tile_done(std::uint64_t primary_rays) {
+		this->tiles_done.fetch_add(1, std::memory_order_relaxed);
+		this->rays_done.fetch_add(primary_rays, std::memory_order_relaxed);
+	}
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	void report(std::stop_token stop);
+	void log() const;
+
+	const std::size_t total_tiles;
+	const std::chrono::duration<double> interval;
+	const clock::time_point start;
+	std::atomic<std::uint64_t> tiles_done = 0;
+	std::atomic<std::uint64_t> rays_done = 0;
+
+	std::mutex mutex;
+	std::condition_variable_any wake;
+	std::jthread reporter;
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+
+// PCG32 generator (O'Neill, pcg-random.org).
+// Every stream of the same seed yields an independent sequence.
+// Rendering uses one stream per tile, so images do not depend on how tiles are scheduled.
+class Rng {
+public:
+	Rng(std::uint64_t seed, std::uint64_t stream)
+		: state{0}
+		, inc{(stream << 1) | 1} {
+		this->next();
+		this->state += seed;
+		this->next();
+	}
+
+	std::uint32_t next() {
+		const std::uint64_t old = this->state;
+		this->state = old * 6364136223846793005ull + this->inc;
+		const std::uint32_t xorshifted = static_cast<std::uint32_t>(((old >> 18u) ^ old) >> 27u);
+		const std::uint32_t rot = static_cast<std::uint32_t>(old >> 59u);
+		return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+	}
+
+	// Uniform in [0, 1).
+	float unit() {
+		return static_cast<float>(this->next() >> 8) * 0x1.0p-24f;
+	}
+
+private:
+	std::uint64_t state;
+	std::uint64_t inc;
+};
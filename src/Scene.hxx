@@ -1,11 +1,26 @@
 #pragma once
-#include <vector>
+#include <span>
+#include <memory>
+#include <cstdint>
 #include "stdxx/vector.hxx"
 #include "Voxel.hxx"
+#include "Occupancy.hxx"
+#include "DistanceField.hxx"
+#include "Box.hxx"
+#include "morton.hxx"
 
+// Voxels stored in bricks of 8x8x8.
+// Voxels within a brick and the bricks in memory both follow Morton order,
+// so voxels close in any direction are close in memory.
+// All empty bricks share the transparent brick 0.
+// The bricks are read only and live either on the heap (see SceneBuilder) or in a mapped scene file.
 struct Scene {
-    std::vector<Voxel> voxels;
-    stx::size3u size;
+    constexpr static std::uint32_t brick_shift = 3;
+    constexpr static std::uint32_t brick_edge = 1 << brick_shift;
+    constexpr static std::uint32_t brick_mask = brick_edge - 1;
+    constexpr static std::size_t brick_volume = brick_edge * brick_edge * brick_edge;
+
+    class Cursor;
 
     const Voxel & operator()(std::int64_t x, std::int64_t y, std::int64_t z) const {
         if(x >= this->size.x) return voxel::transparent;
@@ -16,10 +31,90 @@ struct Scene {
         if(y < 0) return voxel::transparent;
         if(z < 0) return voxel::transparent;
 
-        return this->voxels[
-            (z * this->size.x * this->size.y) +
-            (y * this->size.x               ) +
-            (x                              )
-        ];
+        const Voxel * brick = this->brick(
+            static_cast<std::uint32_t>(x) >> brick_shift,
+            static_cast<std::uint32_t>(y) >> brick_shift,
+            static_cast<std::uint32_t>(z) >> brick_shift);
+        return brick[local_index(x, y, z)];
     } 
-};
\ No newline at end of file
+
+    std::size_t brick_number(std::uint32_t bx, std::uint32_t by, std::uint32_t bz) const {
+        return (std::size_t{bz} * this->bricks.y + by) * this->bricks.x + bx;
+    }
+
+    const Voxel * brick(std::uint32_t bx, std::uint32_t by, std::uint32_t bz) const {
+        return this->brick_data.data() + this->brick_index[this->brick_number(bx, by, bz)] * brick_volume;
+    }
+
+    bool brick_empty(std::uint32_t bx, std::uint32_t by, std::uint32_t bz) const {
+        return this->brick_index[this->brick_number(bx, by, bz)] == 0;
+    }
+
+    // Voxel coordinates covered by the scene.
+    Box bounds() const {
+        return Box {
+            .min = {0, 0, 0},
+            .max = {
+                static_cast<std::int32_t>(this->size.x) - 1,
+                static_cast<std::int32_t>(this->size.y) - 1,
+                static_cast<std::int32_t>(this->size.z) - 1,
+            },
+        };
+    }
+
+    // Transparent region around coords for ray_cast to skip.
+    // Uses the distance field if the scene has one, the occupancy otherwise.
+    std::optional<Box> empty_box(const stx::position3i & coords) const {
+        if(this->distance) return this->distance->empty_box(coords);
+        return this->occupancy.empty_block(coords);
+    }
+
+    static std::uint32_t local_index(std::int64_t x, std::int64_t y, std::int64_t z) {
+        return static_cast<std::uint32_t>(morton_encode(x & brick_mask, y & brick_mask, z & brick_mask));
+    }
+
+    stx::size3u size;
+    // Size of the brick grid.
+    stx::size3u bricks;
+    // Slot in brick_data of every brick, bricks in x, y, z order.
+    std::span<const std::uint32_t> brick_index;
+    std::span<const Voxel> brick_data;
+    Occupancy occupancy;
+    // Only built on request, see load_scene.
+    std::shared_ptr<const DistanceField> distance;
+    // Keeps the memory behind brick_index and brick_data alive.
+    std::shared_ptr<const void> storage;
+};
+
+
+
+// Voxel lookups along a ray.
+// Keeps the brick of the last lookup, so steps inside a brick skip the brick index.
+class Scene::Cursor {
+public:
+    Cursor(const Scene & scene) : scene{scene} {}
+
+    const Voxel & operator()(std::int32_t x, std::int32_t y, std::int32_t z) {
+        if(x < 0 || static_cast<std::uint32_t>(x) >= this->scene.size.x) return voxel::transparent;
+        if(y < 0 || static_cast<std::uint32_t>(y) >= this->scene.size.y) return voxel::transparent;
+        if(z < 0 || static_cast<std::uint32_t>(z) >= this->scene.size.z) return voxel::transparent;
+
+        const std::uint32_t bx = static_cast<std::uint32_t>(x) >> brick_shift;
+        const std::uint32_t by = static_cast<std::uint32_t>(y) >> brick_shift;
+        const std::uint32_t bz = static_cast<std::uint32_t>(z) >> brick_shift;
+        if(!this->current || bx != this->bx || by != this->by || bz != this->bz) {
+            this->current = this->scene.brick(bx, by, bz);
+            this->bx = bx;
+            this->by = by;
+            this->bz = bz;
+        }
+        return this->current[local_index(x, y, z)];
+    }
+
+private:
+    const Scene & scene;
+    const Voxel * current = nullptr;
+    std::uint32_t bx = 0;
+    std::uint32_t by = 0;
+    std::uint32_t bz = 0;
+};
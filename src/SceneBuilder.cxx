@@ -0,0 +1,101 @@
+#include <algorithm>
+#include "SceneBuilder.hxx"
+
+namespace {
+	std::uint32_t bricks_for(std::uint32_t voxels) {
+		return (voxels + Scene::brick_mask) >> Scene::brick_shift;
+	}
+
+
+
+	struct Storage {
+		std::vector<std::uint32_t> brick_index;
+		std::vector<Voxel> brick_data;
+	};
+}
+
+
+
+SceneBuilder::SceneBuilder(stx::size3u size)
+	: size{size}
+	, bricks{bricks_for(size.x), bricks_for(size.y), bricks_for(size.z)} {
+
+	std::vector<std::pair<std::uint64_t, std::size_t>> order;
+	for(std::uint32_t bz = 0; bz < this->bricks.z; ++bz) {
+		for(std::uint32_t by = 0; by < this->bricks.y; ++by) {
+			for(std::uint32_t bx = 0; bx < this->bricks.x; ++bx) {
+				order.push_back({morton_encode(bx, by, bz), this->brick_number(bx, by, bz)});
+			}
+		}
+	}
+	std::sort(order.begin(), order.end());
+
+	this->brick_index.resize(order.size());
+	for(std::size_t slot = 0; slot < order.size(); ++slot) {
+		this->brick_index[order[slot].second] = static_cast<std::uint32_t>(slot + 1);
+	}
+	this->brick_data.resize((order.size() + 1) * Scene::brick_volume, voxel::transparent);
+}
+
+
+
+void SceneBuilder::write_row(std::uint32_t y, std::uint32_t z, const std::uint8_t * rgba) {
+	const std::uint32_t local_yz = Scene::local_index(0, y, z);
+	for(std::uint32_t bx = 0; bx < this->bricks.x; ++bx) {
+		const std::uint32_t slot = this->brick_index[this->brick_number(bx, y >> Scene::brick_shift, z >> Scene::brick_shift)];
+		Voxel * brick = this->brick_data.data() + slot * Scene::brick_volume;
+		const std::uint32_t x_begin = bx << Scene::brick_shift;
+		const std::uint32_t x_end = std::min(x_begin + Scene::brick_edge, this->size.x);
+		for(std::uint32_t x = x_begin; x < x_end; ++x) {
+			const std::uint8_t * pixel = rgba + 4 * std::size_t{x};
+			brick[local_yz | morton_spread(x & Scene::brick_mask)] = voxel::from_rgba8(pixel[0], pixel[1], pixel[2], pixel[3]);
+		}
+	}
+}
+
+
+
+Scene SceneBuilder::build() && {
+	this->compact();
+
+	auto storage = std::make_shared<Storage>(Storage {
+		.brick_index = std::move(this->brick_index),
+		.brick_data = std::move(this->brick_data),
+	});
+
+	Scene scene;
+	scene.size = this->size;
+	scene.bricks = this->bricks;
+	scene.brick_index = storage->brick_index;
+	scene.brick_data = storage->brick_data;
+	scene.storage = std::move(storage);
+	scene.occupancy = Occupancy{scene};
+	return scene;
+}
+
+
+
+void SceneBuilder::compact() {
+	constexpr std::size_t brick_volume = Scene::brick_volume;
+
+	std::vector<std::size_t> brick_of_slot(this->brick_data.size() / brick_volume, 0);
+	for(std::size_t brick = 0; brick < this->brick_index.size(); ++brick) {
+		brick_of_slot[this->brick_index[brick]] = brick;
+	}
+
+	std::vector<Voxel> data(brick_volume, voxel::transparent);
+	for(std::size_t slot = 1; slot < brick_of_slot.size(); ++slot) {
+		const std::size_t brick = brick_of_slot[slot];
+		const auto begin = this->brick_data.begin() + slot * brick_volume;
+		const auto end = begin + brick_volume;
+		if(this->brick_index[brick] != slot) continue;
+		if(std::all_of(begin, end, voxel::is_transparent)) {
+			this->brick_index[brick] = 0;
+		}
+		else {
+			this->brick_index[brick] = static_cast<std::uint32_t>(data.size() / brick_volume);
+			data.insert(data.end(), begin, end);
+		}
+	}
+	this->brick_data = std::move(data);
+}
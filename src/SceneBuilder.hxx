@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "stdxx/vector.hxx"
+#include "Scene.hxx"
+
+// Heap storage for a scene under construction.
+// Starts with every brick allocated and transparent. build() drops the empty ones.
+class SceneBuilder {
+public:
+	SceneBuilder(stx::size3u size);
+
+	// Unchecked write access. Distinct voxels may be written from different threads.
+	Voxel & voxel(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+		const std::uint32_t slot = this->brick_index[this->brick_number(x >> Scene::brick_shift, y >> Scene::brick_shift, z >> Scene::brick_shift)];
+		return this->brick_data[slot * Scene::brick_volume + Scene::local_index(x, y, z)];
+	}
+
+	// Imports one row of size.x RGBA8 pixels along x.
+	// The brick is resolved once per 8 voxels, with packed storage every voxel is a plain 4 byte copy.
+	void write_row(std::uint32_t y, std::uint32_t z, const std::uint8_t * rgba);
+
+	// Shares the transparent brick 0 between all empty bricks, builds the occupancy and hands the storage to the scene.
+	Scene build() &&;
+
+	stx::size3u size;
+	stx::size3u bricks;
+
+private:
+	std::size_t brick_number(std::uint32_t bx, std::uint32_t by, std::uint32_t bz) const {
+		return (std::size_t{bz} * this->bricks.y + by) * this->bricks.x + bx;
+	}
+
+	void compact();
+
+	std::vector<std::uint32_t> brick_index;
+	std::vector<Voxel> brick_data;
+};
@@ -0,0 +1,56 @@
+#include "SceneCache.hxx"
+#include <algorithm>
+#include "stdxx/log.hxx"
+#include "load_scene.hxx"
+
+namespace {
+	// Newest of the manifest and the scene files it references, wherever they are.
+	std::filesystem::file_time_type newest_write_time(const std::filesystem::path & path) {
+		std::filesystem::file_time_type newest = std::filesystem::last_write_time(path / "manifest.json");
+		const stx::json::node manifest = stx::json::from_file(path / "manifest.json");
+		for(const std::filesystem::path & file : scene_files(path, stx::json::iterator{manifest})) {
+			newest = std::max(newest, std::filesystem::last_write_time(file));
+		}
+		return newest;
+	}
+
+
+
+	std::shared_ptr<const Project> load_project(const std::filesystem::path & path, ThreadPool & pool) {
+		stx::json::node manifest = stx::json::from_file(path / "manifest.json");
+		Scene scene = load_scene(path, stx::json::iterator{manifest}, pool);
+		return std::make_shared<const Project>(Project{std::move(manifest), std::move(scene)});
+	}
+}
+
+
+
+SceneCache::SceneCache(std::size_t capacity)
+	: capacity{std::max<std::size_t>(capacity, 1)} {}
+
+
+
+std::shared_ptr<const Project> SceneCache::get(const std::filesystem::path & path, ThreadPool & pool) {
+	const std::filesystem::path key = std::filesystem::canonical(path);
+	const std::filesystem::file_time_type mtime = newest_write_time(key);
+
+	const auto cached = std::find_if(std::begin(this->entries), std::end(this->entries), [&] (const Entry & entry) {
+		return entry.path == key;
+	});
+	if(cached != std::end(this->entries)) {
+		if(cached->mtime == mtime) {
+			this->entries.splice(std::begin(this->entries), this->entries, cached);
+			return this->entries.front().project;
+		}
+		stx::log[stx::INFO] << "Project " << key << " changed, reloading";
+		this->entries.erase(cached);
+	}
+
+	stx::log[stx::INFO] << "Loading project " << key;
+	this->entries.push_front(Entry{key, mtime, load_project(key, pool)});
+	while(this->entries.size() > this->capacity) {
+		stx::log[stx::INFO] << "Evicting project " << this->entries.back().path;
+		this->entries.pop_back();
+	}
+	return this->entries.front().project;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <list>
+#include <memory>
+#include <filesystem>
+#include "stdxx/json.hxx"
+#include "Scene.hxx"
+#include "ThreadPool.hxx"
+
+// A loaded project directory: its manifest and its scene.
+struct Project {
+	stx::json::node manifest;
+	Scene scene;
+};
+
+
+
+// Keeps the most recently used projects loaded.
+// A project is reloaded once its manifest or any scene file the manifest references,
+// its "voxels" file or "albedo" images, is newer than the cached copy.
+class SceneCache {
+public:
+	SceneCache(std::size_t capacity);
+
+	// Loads the project or returns the cached one. Projects handed out stay valid
+	// after they are evicted.
+	std::shared_ptr<const Project> get(const std::filesystem::path & path, ThreadPool & pool);
+
+private:
+	struct Entry {
+		std::filesystem::path path;
+		std::filesystem::file_time_type mtime;
+		std::shared_ptr<const Project> project;
+	};
+
+	std::size_t capacity;
+	// Most recently used first.
+	std::list<Entry> entries;
+};
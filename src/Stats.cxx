@@ -0,0 +1,26 @@
+#include "Stats.hxx"
+#include "stdxx/log.hxx"
+
+Stats & Stats::operator+=(const Stats & other) {
+	this->primary_rays += other.primary_rays;
+	this->secondary_rays += other.secondary_rays;
+	this->voxel_steps += other.voxel_steps;
+	this->lost_rays += other.lost_rays;
+	this->early_terminations += other.early_terminations;
+	return *this;
+}
+
+
+
+void stats::log(const Stats & stats) {
+	const std::uint64_t rays = stats.primary_rays + stats.secondary_rays;
+	stx::log[stx::INFO] << "Statistics";
+	stx::log.indent_in();
+	stx::log[stx::WRITE] << "Primary rays:       " << stats.primary_rays;
+	stx::log[stx::WRITE] << "Secondary rays:     " << stats.secondary_rays;
+	stx::log[stx::WRITE] << "Voxel steps:        " << stats.voxel_steps;
+	stx::log[stx::WRITE] << "Steps per ray:      " << (rays ? static_cast<double>(stats.voxel_steps) / rays : 0.0);
+	stx::log[stx::WRITE] << "Lost rays:          " << stats.lost_rays;
+	stx::log[stx::WRITE] << "Early terminations: " << stats.early_terminations;
+	stx::log.indent_out();
+}
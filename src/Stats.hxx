@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+// Traversal counters of a render.
+struct Stats {
+	std::uint64_t primary_rays = 0;
+	std::uint64_t secondary_rays = 0;
+	std::uint64_t voxel_steps = 0;
+	std::uint64_t lost_rays = 0;
+	std::uint64_t early_terminations = 0;
+
+	Stats & operator+=(const Stats & other);
+};
+
+// Counting is compiled in with -DLUXITE_STATS=ON only.
+// Without it stats::count is empty and vanishes from the hot paths.
+namespace stats {
+#ifdef LUXITE_STATS
+	constexpr inline bool enabled = true;
+#else
+	constexpr inline bool enabled = false;
+#endif
+
+	// Counters of the task running on this thread. Set by render_pass for every tile.
+	inline thread_local Stats * current = nullptr;
+
+	inline void count(std::uint64_t Stats::* counter, std::uint64_t n = 1) {
+		if constexpr (enabled) {
+			if(current) current->*counter += n;
+		}
+	}
+
+	void log(const Stats & stats);
+}
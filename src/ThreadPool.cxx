@@ -0,0 +1,109 @@
+#include "ThreadPool.hxx"
+
+ThreadPool::ThreadPool(std::size_t num_of_threads)
+	: queues(std::max<std::size_t>(num_of_threads, 1)) {
+	for(std::size_t i = 0; i < this->queues.size(); ++i) {
+		this->workers.emplace_back([this, i] { this->work(i); });
+	}
+}
+
+
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard lock{this->mutex};
+		this->stopping = true;
+	}
+	this->wake.notify_all();
+	this->workers.clear();
+}
+
+
+
+void ThreadPool::run(std::size_t count, const Task & task) {
+	std::lock_guard run_lock{this->run_mutex};
+
+	// Hand out contiguous ranges so neighbouring tasks start on the same worker.
+	const std::size_t num_of_threads = this->queues.size();
+	for(std::size_t i = 0; i < num_of_threads; ++i) {
+		std::lock_guard lock{this->queues[i].mutex};
+		for(std::size_t t = count * i / num_of_threads; t < count * (i + 1) / num_of_threads; ++t) {
+			this->queues[i].tasks.push_back(t);
+		}
+	}
+
+	std::unique_lock lock{this->mutex};
+	this->job = &task;
+	this->error = nullptr;
+	this->finished = 0;
+	++this->generation;
+	this->wake.notify_all();
+	this->done.wait(lock, [&] { return this->finished == num_of_threads; });
+	this->job = nullptr;
+
+	if(this->error) std::rethrow_exception(this->error);
+}
+
+
+
+std::size_t ThreadPool::size() const {
+	return this->workers.size();
+}
+
+
+
+void ThreadPool::work(std::size_t worker) {
+	std::size_t seen = 0;
+	while(true) {
+		const Task * task = nullptr;
+		{
+			std::unique_lock lock{this->mutex};
+			this->wake.wait(lock, [&] { return this->stopping || this->generation != seen; });
+			if(this->stopping) return;
+			seen = this->generation;
+			task = this->job;
+		}
+
+		while(const std::optional<std::size_t> index = this->next_task(worker)) {
+			try {
+				(*task)(*index, worker);
+			}
+			catch(...) {
+				std::lock_guard lock{this->mutex};
+				if(!this->error) this->error = std::current_exception();
+			}
+		}
+
+		{
+			std::lock_guard lock{this->mutex};
+			++this->finished;
+		}
+		this->done.notify_one();
+	}
+}
+
+
+
+std::optional<std::size_t> ThreadPool::next_task(std::size_t worker) {
+	{
+		Queue & own = this->queues[worker];
+		std::lock_guard lock{own.mutex};
+		if(!own.tasks.empty()) {
+			const std::size_t task = own.tasks.front();
+			own.tasks.pop_front();
+			return task;
+		}
+	}
+
+	for(std::size_t i = 1; i < this->queues.size(); ++i) {
+		Queue & victim = this->queues[(worker + i) % this->queues.size()];
+		std::lock_guard lock{victim.mutex};
+		if(!victim.tasks.empty()) {
+			const std::size_t task = victim.tasks.back();
+			victim.tasks.pop_back();
+			return task;
+		}
+	}
+
+	return std::nullopt;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <optional>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+// Persistent set of worker threads.
+// Each worker owns a queue of task indices and steals from the back of
+// the other queues once its own runs dry.
+class ThreadPool {
+public:
+	using Task = std::function<void(std::size_t task, std::size_t worker)>;
+
+	ThreadPool(std::size_t num_of_threads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool & operator=(const ThreadPool &) = delete;
+
+	// Calls task(i, worker) for every i in [0, count) and blocks until all are done.
+	// The first exception thrown by a task is rethrown here.
+	void run(std::size_t count, const Task & task);
+
+	std::size_t size() const;
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<std::size_t> tasks;
+	};
+
+	void work(std::size_t worker);
+	std::optional<std::size_t> next_task(std::size_t worker);
+
+	std::vector<Queue> queues;
+	std::vector<std::jthread> workers;
+
+	std::mutex run_mutex;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const Task * job = nullptr;
+	std::exception_ptr error;
+	std::size_t generation = 0;
+	std::size_t finished = 0;
+	bool stopping = false;
+};
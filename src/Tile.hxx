@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "stdxx/vector.hxx"
+
+struct Tile {
+	std::uint32_t x_begin;
+	std::uint32_t y_begin;
+	std::uint32_t x_end;
+	std::uint32_t y_end;
+};
+
+// Splits the frame into row-major tiles of at most tile_size x tile_size pixels.
+inline std::vector<Tile> make_tiles(const stx::size2u resolution, std::uint32_t tile_size) {
+	std::vector<Tile> tiles;
+	for(std::uint32_t y = 0; y < resolution.y; y += tile_size) {
+		for(std::uint32_t x = 0; x < resolution.x; x += tile_size) {
+			tiles.push_back(Tile {
+				.x_begin = x,
+				.y_begin = y,
+				.x_end = std::min(x + tile_size, resolution.x),
+				.y_end = std::min(y + tile_size, resolution.y),
+			});
+		}
+	}
+	return tiles;
+}
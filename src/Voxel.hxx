@@ -1,10 +1,23 @@
 #pragma once
 #include <cstdint>
+#include "Color.hxx"
 
-struct Voxel {
+// 4 bytes per voxel. Default storage.
+struct VoxelRGBA8 {
+    std::uint8_t r, g, b, a;
+};
+
+// 16 bytes per voxel. For scenes with colors outside [0, 1].
+struct VoxelRGBA32F {
     float r, g, b, a;
 };
 
+#ifdef LUXITE_HDR_VOXELS
+using Voxel = VoxelRGBA32F;
+#else
+using Voxel = VoxelRGBA8;
+#endif
+
 namespace voxel {
     constexpr inline static Voxel transparent {
         .r = 0,
@@ -12,4 +25,44 @@ namespace voxel {
         .b = 0,
         .a = 0,
     };
-}
\ No newline at end of file
+
+    inline bool is_transparent(const Voxel & v) {
+        return v.a == 0;
+    }
+
+    inline Color to_color(const VoxelRGBA8 & v) {
+        return Color {
+            .r = static_cast<float>(v.r) / 255.f,
+            .g = static_cast<float>(v.g) / 255.f,
+            .b = static_cast<float>(v.b) / 255.f,
+            .a = static_cast<float>(v.a) / 255.f,
+        };
+    }
+
+    inline Color to_color(const VoxelRGBA32F & v) {
+        return Color {
+            .r = v.r,
+            .g = v.g,
+            .b = v.b,
+            .a = v.a,
+        };
+    }
+
+    inline Voxel from_rgba8(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a) {
+#ifdef LUXITE_HDR_VOXELS
+        return Voxel {
+            .r = static_cast<float>(r) / 255.f,
+            .g = static_cast<float>(g) / 255.f,
+            .b = static_cast<float>(b) / 255.f,
+            .a = static_cast<float>(a) / 255.f,
+        };
+#else
+        return Voxel {
+            .r = r,
+            .g = g,
+            .b = b,
+            .a = a,
+        };
+#endif
+    }
+}
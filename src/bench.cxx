@@ -0,0 +1,243 @@
+#include <iostream>
+#include <chrono>
+#include <span>
+#include <string_view>
+#include <functional>
+#include <thread>
+
+#include "stdxx/json.hxx"
+
+#include "render.hxx"
+#include "ray_cast_scene.hxx"
+#include "load_scene.hxx"
+#include "SceneBuilder.hxx"
+#include "load_camera.hxx"
+#include "load_resolution.hxx"
+#include "angle.hxx"
+#include "Rng.hxx"
+
+// Benchmark suite of the renderer.
+// Usage: bench [project] [--config <name>]... [--threads N] [--accel occupancy|distance]
+// Runs ray_cast, render_rec and render on the project (default demo/a) and on synthetic scenes
+// at the small, medium and large configs and prints the results as JSON to stdout.
+// "rays" counts every traced ray including bounces. The bench links luxite_stats, so render_rec
+// and render count rays and voxel steps in release builds too, at the cost of the counting itself.
+
+static_assert(stats::enabled, "bench must link luxite_stats");
+
+namespace {
+	using clock = std::chrono::steady_clock;
+
+	constexpr std::uint32_t synthetic_size = 64;
+	constexpr std::size_t ray_cast_rays = 1 << 20;
+	constexpr std::size_t render_rec_rays = 1 << 16;
+
+
+
+	struct BenchScene {
+		std::string name;
+		Scene scene;
+		Camera camera;
+	};
+
+
+
+	Scene make_scene(stx::size3u size, const std::function<bool(std::uint32_t, std::uint32_t, std::uint32_t)> & opaque) {
+		SceneBuilder builder {size};
+		for(std::uint32_t z = 0; z < size.z; ++z) {
+			for(std::uint32_t y = 0; y < size.y; ++y) {
+				for(std::uint32_t x = 0; x < size.x; ++x) {
+					if(!opaque(x, y, z)) continue;
+					builder.voxel(x, y, z) = voxel::from_rgba8(x * 4, y * 4, z * 4, 255);
+				}
+			}
+		}
+		return std::move(builder).build();
+	}
+
+
+
+	// Same view as the demo project, scaled to the synthetic scene size.
+	Camera synthetic_camera() {
+		const float s = static_cast<float>(synthetic_size);
+		return Camera {
+			.position = {-s / 4, -s / 4, s / 2},
+			.rotation
+				= stx::quatf::from_axis_angle(stx::vector3f{1,0,0}, deg_to_rad(25.f))
+				* stx::quatf::from_axis_angle(stx::vector3f{0,0,1}, deg_to_rad(45.f)),
+		};
+	}
+
+
+
+	std::vector<BenchScene> synthetic_scenes() {
+		const stx::size3u size {synthetic_size, synthetic_size, synthetic_size};
+		Rng rng {0, 0};
+		std::vector<bool> sparse;
+		for(std::size_t i = 0; i < std::size_t{size.x} * size.y * size.z; ++i) {
+			sparse.push_back(rng.unit() < 0.01f);
+		}
+
+		std::vector<BenchScene> scenes;
+		scenes.push_back({"empty", make_scene(size, [] (auto, auto, auto) {
+			return false;
+		}), synthetic_camera()});
+		scenes.push_back({"dense", make_scene(size, [] (auto, auto, auto) {
+			return true;
+		}), synthetic_camera()});
+		scenes.push_back({"checkerboard", make_scene(size, [] (auto x, auto y, auto z) {
+			return (x + y + z) % 2 == 0;
+		}), synthetic_camera()});
+		scenes.push_back({"sparse_random", make_scene(size, [&] (auto x, auto y, auto z) {
+			return sparse[(std::size_t{z} * size.y + y) * size.x + x];
+		}), synthetic_camera()});
+		return scenes;
+	}
+
+
+
+	double seconds_since(clock::time_point start) {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+
+
+	// Writes a string as a quoted JSON string.
+	struct JsonString {
+		std::string_view value;
+	};
+
+	std::ostream & operator<<(std::ostream & out, const JsonString & json) {
+		constexpr std::string_view hex = "0123456789abcdef";
+		out << '"';
+		for(const char c : json.value) {
+			const unsigned char u = static_cast<unsigned char>(c);
+			if(c == '"' || c == '\\') out << '\\' << c;
+			else if(u < 0x20) out << "\\u00" << hex[u >> 4] << hex[u & 15];
+			else out << c;
+		}
+		return out << '"';
+	}
+
+
+
+	void print_result(bool & first, std::string_view scene, std::string_view config, std::string_view kernel, std::size_t primary_rays, std::uint64_t rays, std::uint64_t steps, double seconds) {
+		std::cout
+			<< (first ? "\n" : ",\n")
+			<< "    {"
+			<< "\"scene\": " << JsonString{scene} << ", "
+			<< "\"config\": " << JsonString{config} << ", "
+			<< "\"kernel\": " << JsonString{kernel} << ", "
+			<< "\"primary_rays\": " << primary_rays << ", "
+			<< "\"rays\": " << rays << ", "
+			<< "\"seconds\": " << seconds << ", "
+			<< "\"rays_per_sec\": " << static_cast<double>(rays) / seconds << ", "
+			<< "\"voxel_steps_per_sec\": " << static_cast<double>(steps) / seconds << ", "
+			<< "\"ms_per_frame\": " << seconds * 1000.0
+			<< "}";
+		first = false;
+	}
+
+
+
+	void bench_scene(bool & first, const BenchScene & bench, std::string_view config, stx::size2u resolution, const Options & options, ThreadPool & pool) {
+		const CameraRays camera_rays {bench.camera, resolution};
+		const std::size_t pixels = std::size_t{resolution.x} * resolution.y;
+		Rng rng {options.seed, 0};
+
+		{
+			std::size_t steps = 0;
+			const clock::time_point start = clock::now();
+			for(std::size_t i = 0; i < ray_cast_rays; ++i) {
+				const std::size_t pixel = i % pixels;
+				const stx::vector3f dir = camera_rays(pixel % resolution.x, pixel / resolution.x);
+				ray_cast(stx::vector3f{camera_rays.origin}, stx::normalized(dir), [&] (const Intersection & intersection) {
+					++steps;
+					return voxel::is_transparent(bench.scene(intersection.coords.x, intersection.coords.y, intersection.coords.z));
+				}, [&] (const stx::position3i & coords) {
+					return bench.scene.empty_box(coords);
+				}, bench.scene.bounds());
+			}
+			print_result(first, bench.name, config, "ray_cast", ray_cast_rays, ray_cast_rays, steps, seconds_since(start));
+		}
+
+		{
+			const std::size_t rays = std::min(pixels, render_rec_rays);
+			// render_rec counts every ray it casts as a secondary ray, the first one included.
+			Stats stats;
+			stats::current = &stats;
+			const clock::time_point start = clock::now();
+			for(std::size_t i = 0; i < rays; ++i) {
+				const std::size_t pixel = i * pixels / rays;
+				const stx::vector3f dir = camera_rays(pixel % resolution.x, pixel / resolution.x);
+				render_rec(options.max_bounce, false, options.split, options.max_distance, bench.scene, camera_rays.origin, dir, rng);
+			}
+			const double seconds = seconds_since(start);
+			stats::current = nullptr;
+			print_result(first, bench.name, config, "render_rec", rays, stats.secondary_rays, stats.voxel_steps, seconds);
+		}
+
+		{
+			const clock::time_point start = clock::now();
+			const Framebuffer frame = render(resolution, bench.scene, bench.camera, options, pool);
+			const double seconds = seconds_since(start);
+			const Stats & stats = frame.stats;
+			print_result(first, bench.name, config, "render", pixels * options.samples, stats.primary_rays + stats.secondary_rays, stats.voxel_steps, seconds);
+		}
+	}
+}
+
+
+
+int main(int argc, char ** argv) {
+	const std::filesystem::path in_path {argc > 1 ? argv[1] : "demo/a"};
+	std::vector<std::string> configs;
+	bool distance = false;
+	Options options;
+	options.threads = std::max(std::thread::hardware_concurrency(), 1u);
+	options.quiet = true;
+
+	const std::span<char *> rest {argv + std::min(argc, 2), argv + argc};
+	for(std::size_t i = 0; i < rest.size(); ++i) {
+		const std::string_view option {rest[i]};
+		if(option == "--threads" && i + 1 < rest.size()) {
+			options.threads = std::max(std::stoul(rest[++i]), 1ul);
+		}
+		else if(option == "--config" && i + 1 < rest.size()) {
+			configs.push_back(rest[++i]);
+		}
+		else if(option == "--accel" && i + 1 < rest.size()) {
+			const std::string_view name {rest[++i]};
+			if(name == "distance") distance = true;
+			else if(name != "occupancy") throw std::runtime_error{"--accel must be occupancy or distance"};
+		}
+	}
+	if(configs.empty()) {
+		configs = {"small", "medium", "large"};
+	}
+
+	const stx::json::node data = stx::json::from_file(in_path/"manifest.json");
+	const stx::json::iterator manifest {data};
+
+	ThreadPool pool {options.threads};
+	std::vector<BenchScene> scenes = synthetic_scenes();
+	for(BenchScene & scene : scenes) {
+		if(distance) scene.scene.distance = std::make_shared<const DistanceField>(scene.scene);
+	}
+	BenchScene project {in_path.string(), load_scene(in_path, manifest, pool), Camera{}};
+	if(distance && !project.scene.distance) {
+		project.scene.distance = std::make_shared<const DistanceField>(project.scene);
+	}
+
+	std::cout << "{\n  \"threads\": " << options.threads << ",\n  \"results\": [";
+	bool first = true;
+	for(const std::string & config : configs) {
+		const stx::size2u resolution = load_resolution(manifest, config);
+		project.camera = load_camera(manifest, config);
+		bench_scene(first, project, config, resolution, options, pool);
+		for(const BenchScene & scene : scenes) {
+			bench_scene(first, scene, config, resolution, options, pool);
+		}
+	}
+	std::cout << "\n  ]\n}\n";
+}
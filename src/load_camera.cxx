@@ -1,5 +1,4 @@
 #include "load_camera.hxx"
-#include "angle.hxx"
 
 namespace {
 	stx::position3f load_camera_position(const stx::json::iterator json) {
@@ -25,30 +24,59 @@ namespace {
 		if(!z)throw stx::json::format_error{"Cannot load camera rotation.z"};
 		return {*x, *y, *z};
 	};
+
+
+
+	float load_camera_fov(const stx::json::iterator json) {
+		if(!json) return Camera{}.fov;
+		const std::optional<float> fov = stx::static_opt_cast<float>(json.number());
+		if(!fov) throw stx::json::format_error{"Cannot load camera fov"};
+		return *fov;
+	}
+
+
+
+	CameraKeyframe load_camera_keyframe(const stx::json::iterator json_camera, std::size_t frame) {
+		return CameraKeyframe {
+			.frame = frame,
+			.position = load_camera_position(json_camera["position"]),
+			.rotation = load_camera_rotation(json_camera["rotation"]),
+			.fov = load_camera_fov(json_camera["fov"]),
+		};
+	}
+
+
+
+	std::vector<CameraKeyframe> load_camera_keyframes(const stx::json::iterator json) {
+		std::vector<CameraKeyframe> keyframes;
+		for(std::size_t i = 0; json[i]; ++i) {
+			const std::optional<std::uint32_t> frame = json[i]["frame"].u32();
+			if(!frame) throw stx::json::format_error{"Cannot load camera keyframes[" + std::to_string(i) + "].frame"};
+			if(!keyframes.empty() && *frame <= keyframes.back().frame) {
+				throw stx::json::format_error{"Camera keyframes must be sorted by frame"};
+			}
+			keyframes.push_back(load_camera_keyframe(json[i], *frame));
+		}
+		if(keyframes.empty()) throw stx::json::format_error{"Cannot load camera keyframes"};
+		return keyframes;
+	}
 }
 
 
 
-Camera load_camera(const stx::json::iterator json_manifest, const std::string & config_name) {
-	return Camera {
-		.position = {-2,-2, 4},
-		.rotation
-			= stx::quatf::from_axis_angle(stx::vector3f{1,0,0}, deg_to_rad(25.f))
-			* stx::quatf::from_axis_angle(stx::vector3f{0,0,1}, deg_to_rad(45.f)),
-	};
-	
+CameraPath load_camera_path(const stx::json::iterator json_manifest, const std::string & config_name) {
 	const stx::json::iterator json_config = json_manifest["config"][config_name];
     if(!json_config) throw stx::json::format_error {"Cannot load config " + config_name};
     const stx::json::iterator json_camera = json_config["camera"];
-	const stx::position3f position = load_camera_position(json_camera["position"]);
-	const stx::vector3f rotation = load_camera_rotation(json_camera["rotation"]);
-
-	std::cout << position << rotation << "\n"; 
-    
-    return Camera {
-		.position = position,
-		.rotation
-			= stx::quatf::from_axis_angle(stx::vector3f{1,0,0}, deg_to_rad(rotation.x))
-			* stx::quatf::from_axis_angle(stx::vector3f{0,0,1}, deg_to_rad(rotation.z)),
-	};
+	if(!json_camera) throw stx::json::format_error{"Cannot load camera"};
+
+	const stx::json::iterator json_keyframes = json_camera["keyframes"];
+	if(json_keyframes) return CameraPath{load_camera_keyframes(json_keyframes)};
+	return CameraPath{{load_camera_keyframe(json_camera, 0)}};
+}
+
+
+
+Camera load_camera(const stx::json::iterator json_manifest, const std::string & config_name) {
+	return load_camera_path(json_manifest, config_name)(0);
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include "Camera.hxx"
+#include "CameraPath.hxx"
 #include "stdxx/json.hxx"
 
+CameraPath load_camera_path(const stx::json::iterator manifest, const std::string & config_name);
 Camera load_camera(const stx::json::iterator manifest, const std::string & config_name);
@@ -0,0 +1,35 @@
+#include "load_quality.hxx"
+
+namespace {
+    void load_count(const stx::json::iterator json, const std::string & name, std::size_t & value) {
+        if(!json) return;
+        const std::optional<std::uint32_t> count = json.u32();
+        if(!count || *count < 1) throw stx::json::format_error{"Cannot load quality." + name};
+        value = *count;
+    }
+
+
+
+    template<typename T>
+    void load_positive(const stx::json::iterator json, const std::string & name, T & value) {
+        if(!json) return;
+        const std::optional<T> number = stx::static_opt_cast<T>(json.number());
+        if(!number || !(*number > 0)) throw stx::json::format_error{"Cannot load quality." + name};
+        value = *number;
+    }
+}
+
+
+
+Options load_quality(const stx::json::iterator json_manifest, const std::string & config_name, Options options) {
+    const stx::json::iterator json_config = json_manifest["config"][config_name];
+    if(!json_config) throw stx::json::format_error {"Cannot load config " + config_name};
+    const stx::json::iterator json = json_config["quality"];
+    if(!json) return options;
+    load_count(json["spp"], "spp", options.samples);
+    load_count(json["max_bounce"], "max_bounce", options.max_bounce);
+    load_count(json["split"], "split", options.split);
+    load_positive(json["max_distance"], "max_distance", options.max_distance);
+    load_positive(json["time_budget"], "time_budget", options.time_budget);
+    return options;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include "stdxx/json.hxx"
+#include "Options.hxx"
+
+// Applies the optional "quality" block of a config to options:
+// "spp", "max_bounce", "split", "max_distance" and "time_budget".
+Options load_quality(const stx::json::iterator manifest, const std::string & config_name, Options options);
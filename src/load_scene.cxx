@@ -1,5 +1,10 @@
+#include <memory>
+#include <vector>
+#include <string>
 #include "load_scene.hxx"
 #include "stb/stb_image.h"
+#include "SceneBuilder.hxx"
+#include "lxv.hxx"
 
 namespace {
     stx::size3u load_size(const stx::json::iterator json) {
@@ -10,37 +15,150 @@ namespace {
         if(!x)throw stx::json::format_error{"Cannot load scene size.x"};
         if(!y)throw stx::json::format_error{"Cannot load scene size.y"};
         if(!z)throw stx::json::format_error{"Cannot load scene size.z"};
+        if(*x == 0 || *y == 0 || *z == 0) throw stx::json::format_error{"Scene size must not be 0"};
         return {*x, *y, *z};
     };
-}
 
 
-Scene load_scene(const std::filesystem::path & path, const stx::json::iterator manifest) {
-    const std::filesystem::path albedo_path = path/"albedo.png";
 
-    int image_w, image_h, image_comp;
-    std::uint8_t * image_data = stbi_load(albedo_path.c_str(), &image_w, &image_h, &image_comp, STBI_rgb_alpha);
-    if(image_data == nullptr) throw std::runtime_error{"Cannot load scene image: " + albedo_path.string()};
-    
-    Scene scene;
+    std::vector<std::filesystem::path> load_albedo_paths(const std::filesystem::path & path, const stx::json::iterator json) {
+        if(!json) return {path/"albedo.png"};
+        if(const std::optional<std::string> file = json.string()) return {path / *file};
+
+        std::vector<std::filesystem::path> paths;
+        for(std::size_t i = 0; json[i]; ++i) {
+            const std::optional<std::string> file = json[i].string();
+            if(!file) throw stx::json::format_error{"Cannot load scene albedo[" + std::to_string(i) + "]"};
+            paths.push_back(path / *file);
+        }
+        if(paths.empty()) throw stx::json::format_error{"Cannot load scene albedo"};
+        return paths;
+    }
+
+
+
+    // The .lxv file of "voxels", nothing if the scene comes from albedo images.
+    std::optional<std::string> load_voxels_file(const stx::json::iterator json) {
+        if(!json) return std::nullopt;
+        const std::optional<std::string> file = json.string();
+        if(!file) throw stx::json::format_error{"Cannot load scene voxels"};
+        return file;
+    }
+
+
+
+    // A slice image holds one or more z-layers read as consecutive rows of size.x pixels.
+    struct Slice {
+        std::filesystem::path path;
+        std::uint32_t z_begin;
+        std::uint32_t z_end;
+    };
+
+
+
+    std::vector<Slice> plan_slices(const std::vector<std::filesystem::path> & paths, const stx::size3u size) {
+        std::vector<Slice> slices;
+        std::uint32_t z = 0;
+        for(const std::filesystem::path & path : paths) {
+            int image_w, image_h, image_comp;
+            if(!stbi_info(path.c_str(), &image_w, &image_h, &image_comp)) {
+                throw std::runtime_error{"Cannot load scene image: " + path.string()};
+            }
+            const std::uint64_t pixels = std::uint64_t(image_w) * std::uint64_t(image_h);
+            const std::uint64_t layer_pixels = std::uint64_t(size.x) * size.y;
+            if(pixels % layer_pixels != 0) {
+                throw std::runtime_error{
+                    "Scene image " + path.string() + " has "
+                    + std::to_string(image_w) + "x" + std::to_string(image_h) + " pixels, expected a multiple of "
+                    + std::to_string(size.x) + "x" + std::to_string(size.y)};
+            }
+            const std::uint64_t layers = pixels / layer_pixels;
+            if(layers > size.z - z) {
+                throw std::runtime_error{
+                    "Scene images hold more z-layers than scene size " + std::to_string(size.z)};
+            }
+            slices.push_back(Slice{path, z, z + static_cast<std::uint32_t>(layers)});
+            z += static_cast<std::uint32_t>(layers);
+        }
+        if(z != size.z) {
+            throw std::runtime_error{
+                "Scene images hold " + std::to_string(z) + " z-layers, scene size needs " + std::to_string(size.z)};
+        }
+        return slices;
+    }
+
+
+
+    void load_slice(SceneBuilder & builder, const Slice & slice) {
+        int image_w, image_h, image_comp;
+        const std::unique_ptr<std::uint8_t, decltype(&stbi_image_free)> image_data {
+            stbi_load(slice.path.c_str(), &image_w, &image_h, &image_comp, STBI_rgb_alpha),
+            &stbi_image_free,
+        };
+        if(image_data == nullptr) throw std::runtime_error{"Cannot load scene image: " + slice.path.string()};
 
-    for(std::size_t i = 0; i < image_w * image_h; ++i) {
-        std::uint8_t r = image_data[4 * i + 0];
-        std::uint8_t g = image_data[4 * i + 1];
-        std::uint8_t b = image_data[4 * i + 2];
-        std::uint8_t a = image_data[4 * i + 3];
+        const std::uint8_t * row = image_data.get();
+        for(std::uint32_t z = slice.z_begin; z < slice.z_end; ++z) {
+            for(std::uint32_t y = 0; y < builder.size.y; ++y) {
+                builder.write_row(y, z, row);
+                row += 4 * std::size_t{builder.size.x};
+            }
+        }
+    }
+
+
+
+    // "accel" selects the empty space skipping: "occupancy" (default) or "distance".
+    bool load_accel_distance(const stx::json::iterator json) {
+        if(!json) return false;
+        const std::optional<std::string> accel = json.string();
+        if(accel == "occupancy") return false;
+        if(accel == "distance") return true;
+        throw stx::json::format_error{"Scene accel must be \"occupancy\" or \"distance\""};
+    }
 
-        scene.voxels.push_back(Voxel{
-            .r = static_cast<float>(r) / 255.f,
-            .g = static_cast<float>(g) / 255.f,
-            .b = static_cast<float>(b) / 255.f,
-            .a = static_cast<float>(a) / 255.f,
+
+
+    // Decodes all slice images in parallel, every slice writes straight into its own z-layers.
+    Scene load_scene_png(const std::filesystem::path & path, const stx::json::iterator manifest, ThreadPool & pool) {
+        const stx::size3u size = load_size(manifest["size"]);
+        const std::vector<Slice> slices = plan_slices(load_albedo_paths(path, manifest["albedo"]), size);
+
+        SceneBuilder builder {size};
+        pool.run(slices.size(), [&] (std::size_t i, std::size_t) {
+            load_slice(builder, slices[i]);
         });
+        return std::move(builder).build();
+    }
+
+
+
+    Scene load_scene_voxels(const std::filesystem::path & path, const stx::json::iterator manifest, ThreadPool & pool) {
+        const std::optional<std::string> file = load_voxels_file(manifest["voxels"]);
+        if(!file) return load_scene_png(path, manifest, pool);
+
+        Scene scene = read_lxv(path / *file);
+        const stx::size3u size = manifest["size"] ? load_size(manifest["size"]) : scene.size;
+        if(size.x != scene.size.x || size.y != scene.size.y || size.z != scene.size.z) {
+            throw std::runtime_error{"Scene size in manifest does not match " + *file};
+        }
+        return scene;
     }
+}
 
-    scene.size = load_size(manifest["size"]);
 
-    stbi_image_free(image_data);
 
+Scene load_scene(const std::filesystem::path & path, const stx::json::iterator manifest, ThreadPool & pool) {
+    const bool distance = load_accel_distance(manifest["accel"]);
+    Scene scene = load_scene_voxels(path, manifest, pool);
+    if(distance) scene.distance = std::make_shared<const DistanceField>(scene);
     return scene;
+}
+
+
+
+std::vector<std::filesystem::path> scene_files(const std::filesystem::path & path, const stx::json::iterator manifest) {
+    const std::optional<std::string> file = load_voxels_file(manifest["voxels"]);
+    if(!file) return load_albedo_paths(path, manifest["albedo"]);
+    return {path / *file};
 }
\ No newline at end of file
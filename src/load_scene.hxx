@@ -3,5 +3,14 @@
 #include <filesystem>
 #include "Scene.hxx"
 #include "stdxx/json.hxx"
+#include "ThreadPool.hxx"
 
-Scene load_scene(const std::filesystem::path & path, const stx::json::iterator manifest);
\ No newline at end of file
+// Maps the "voxels" .lxv file of the manifest or decodes its "albedo" images on the pool.
+// "albedo" is a single image or a list of slice images, each holding whole z-layers read as rows of size.x pixels.
+// "accel": "distance" builds a DistanceField for empty space skipping instead of using the occupancy.
+Scene load_scene(const std::filesystem::path & path, const stx::json::iterator manifest, ThreadPool & pool);
+
+
+
+// The files load_scene reads the scene from, the "voxels" file or the "albedo" images.
+std::vector<std::filesystem::path> scene_files(const std::filesystem::path & path, const stx::json::iterator manifest);
\ No newline at end of file
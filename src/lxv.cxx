@@ -0,0 +1,150 @@
+#include <fstream>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include "lxv.hxx"
+#include "MappedFile.hxx"
+
+namespace {
+	constexpr char magic[4] = {'L', 'X', 'V', '\0'};
+	constexpr std::uint64_t section_alignment = 64;
+	constexpr std::uint64_t data_alignment = 4096;
+
+
+
+	std::uint64_t align(std::uint64_t offset, std::uint64_t alignment) {
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+
+
+	void pad(std::ofstream & out, std::uint64_t offset) {
+		const std::uint64_t current = static_cast<std::uint64_t>(out.tellp());
+		const std::vector<char> zeros(offset - current, 0);
+		out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+	}
+
+
+
+	void write_bytes(std::ofstream & out, const void * data, std::size_t size) {
+		out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+	}
+
+
+
+	std::runtime_error format_error(const std::filesystem::path & path, const std::string & reason) {
+		return std::runtime_error{"Invalid scene file " + path.string() + ": " + reason};
+	}
+
+
+
+	template<typename T>
+	const T * section(std::span<const std::byte> bytes, std::uint64_t offset, std::uint64_t count, const std::filesystem::path & path) {
+		if(offset % alignof(T) != 0) throw format_error(path, "misaligned section");
+		if(offset > bytes.size() || count > (bytes.size() - offset) / sizeof(T)) throw format_error(path, "truncated");
+		return reinterpret_cast<const T *>(bytes.data() + offset);
+	}
+}
+
+
+
+void write_lxv(const std::filesystem::path & path, const Scene & scene) {
+	const std::vector<Occupancy::Level> & levels = scene.occupancy.get_levels();
+
+	LxvHeader header {};
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = lxv_version;
+	header.voxel_bytes = sizeof(Voxel);
+	header.occupancy_levels = static_cast<std::uint32_t>(levels.size());
+	header.size[0] = scene.size.x;
+	header.size[1] = scene.size.y;
+	header.size[2] = scene.size.z;
+	header.bricks[0] = scene.bricks.x;
+	header.bricks[1] = scene.bricks.y;
+	header.bricks[2] = scene.bricks.z;
+	header.brick_slots = scene.brick_data.size() / Scene::brick_volume;
+
+	header.brick_index_offset = align(sizeof(LxvHeader), section_alignment);
+	header.occupancy_offset = align(header.brick_index_offset + scene.brick_index.size_bytes(), section_alignment);
+	std::uint64_t occupancy_end = header.occupancy_offset;
+	for(const Occupancy::Level & level : levels) {
+		occupancy_end += sizeof(LxvLevel) + level.bits.size() * sizeof(std::uint64_t);
+	}
+	header.brick_data_offset = align(occupancy_end, data_alignment);
+
+	std::ofstream out {path, std::ios::binary};
+	if(!out) throw std::runtime_error{"Cannot write " + path.string()};
+
+	write_bytes(out, &header, sizeof(header));
+	pad(out, header.brick_index_offset);
+	write_bytes(out, scene.brick_index.data(), scene.brick_index.size_bytes());
+	pad(out, header.occupancy_offset);
+	for(const Occupancy::Level & level : levels) {
+		const LxvLevel entry {
+			.shift = level.shift,
+			.size = {level.size.x, level.size.y, level.size.z},
+			.words = level.bits.size(),
+		};
+		write_bytes(out, &entry, sizeof(entry));
+		write_bytes(out, level.bits.data(), level.bits.size() * sizeof(std::uint64_t));
+	}
+	pad(out, header.brick_data_offset);
+	write_bytes(out, scene.brick_data.data(), scene.brick_data.size_bytes());
+
+	if(!out) throw std::runtime_error{"Cannot write " + path.string()};
+}
+
+
+
+Scene read_lxv(const std::filesystem::path & path) {
+	auto file = std::make_shared<MappedFile>(path);
+	const std::span<const std::byte> bytes = file->bytes();
+
+	const LxvHeader & header = *section<LxvHeader>(bytes, 0, 1, path);
+	if(std::memcmp(header.magic, magic, sizeof(magic)) != 0) throw format_error(path, "not a scene file");
+	if(header.version != lxv_version) throw format_error(path, "unsupported version " + std::to_string(header.version));
+	if(header.voxel_bytes != sizeof(Voxel)) throw format_error(path, "voxel format does not match this build (LUXITE_HDR_VOXELS)");
+
+	Scene scene;
+	scene.size = {header.size[0], header.size[1], header.size[2]};
+	scene.bricks = {header.bricks[0], header.bricks[1], header.bricks[2]};
+	for(std::size_t axis = 0; axis < 3; ++axis) {
+		const std::uint64_t bricks = (std::uint64_t{header.size[axis]} + Scene::brick_edge - 1) >> Scene::brick_shift;
+		if(header.bricks[axis] != bricks) throw format_error(path, "brick grid does not match scene size");
+	}
+
+	const std::uint64_t bricks = std::uint64_t{scene.bricks.x} * scene.bricks.y * scene.bricks.z;
+	const std::uint32_t * brick_index = section<std::uint32_t>(bytes, header.brick_index_offset, bricks, path);
+	if(header.brick_slots > bytes.size() / (Scene::brick_volume * sizeof(Voxel))) throw format_error(path, "truncated");
+	const Voxel * brick_data = section<Voxel>(bytes, header.brick_data_offset, header.brick_slots * Scene::brick_volume, path);
+	for(std::uint64_t brick = 0; brick < bricks; ++brick) {
+		if(brick_index[brick] >= header.brick_slots) throw format_error(path, "brick index out of range");
+	}
+	scene.brick_index = {brick_index, bricks};
+	scene.brick_data = {brick_data, header.brick_slots * Scene::brick_volume};
+
+	// The levels are fully determined by the scene size, anything else would index past the bits.
+	std::vector<Occupancy::Level> levels = Occupancy::empty_levels(scene.size);
+	if(header.occupancy_levels != levels.size()) throw format_error(path, "wrong number of occupancy levels");
+	std::uint64_t offset = header.occupancy_offset;
+	for(Occupancy::Level & level : levels) {
+		const LxvLevel & entry = *section<LxvLevel>(bytes, offset, 1, path);
+		offset += sizeof(LxvLevel);
+		if(entry.shift != level.shift
+		|| entry.size[0] != level.size.x
+		|| entry.size[1] != level.size.y
+		|| entry.size[2] != level.size.z
+		|| entry.words != level.bits.size()) {
+			throw format_error(path, "occupancy level does not match scene size");
+		}
+		const std::uint64_t * words = section<std::uint64_t>(bytes, offset, entry.words, path);
+		offset += entry.words * sizeof(std::uint64_t);
+		std::copy(words, words + entry.words, std::begin(level.bits));
+	}
+	scene.occupancy = Occupancy{scene.size, std::move(levels)};
+	scene.storage = std::move(file);
+
+	return scene;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <filesystem>
+#include "Scene.hxx"
+
+// Native scene file (.lxv).
+// Holds the bricks exactly as Scene keeps them in memory, so a scene is mapped instead of decoded.
+//
+// Layout, all values in host byte order:
+//   LxvHeader
+//   brick index     uint32 per brick, 64 byte aligned
+//   occupancy       per level: LxvLevel followed by its uint64 words, 64 byte aligned
+//   brick data      Voxel[512] per slot, page aligned
+
+constexpr inline std::uint32_t lxv_version = 1;
+
+struct LxvHeader {
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t voxel_bytes;
+	std::uint32_t occupancy_levels;
+	std::uint32_t size[3];
+	std::uint32_t bricks[3];
+	std::uint64_t brick_index_offset;
+	std::uint64_t occupancy_offset;
+	std::uint64_t brick_data_offset;
+	std::uint64_t brick_slots;
+};
+
+struct LxvLevel {
+	std::int32_t shift;
+	std::uint32_t size[3];
+	std::uint64_t words;
+};
+
+void write_lxv(const std::filesystem::path & path, const Scene & scene);
+
+// Maps the file. The scene keeps the mapping alive.
+Scene read_lxv(const std::filesystem::path & path);
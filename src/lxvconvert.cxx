@@ -0,0 +1,42 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+
+#include "stdxx/log.hxx"
+#include "stdxx/json.hxx"
+
+#include "load_scene.hxx"
+#include "lxv.hxx"
+
+// Converts a project (manifest.json + albedo images) into a native .lxv scene file.
+// Add "voxels" : "<file>.lxv" to the manifest to render from the converted file.
+int main(int argc, char ** argv) {
+	stx::log.register_output(std::cout);
+
+	if(argc < 3) {
+		stx::log[stx::ERROR] 
+			<< "To few arguments were provided. Usage: "
+			<< argv[0] << " <project> <output.lxv>";
+		return EXIT_FAILURE;
+	}
+
+	const std::filesystem::path in_path {argv[1]};
+	const std::filesystem::path out_path {argv[2]};
+
+	const stx::json::node data = stx::json::from_file(in_path/"manifest.json");
+	const stx::json::iterator manifest {data};
+
+	std::chrono::steady_clock clock;
+	std::chrono::time_point time_start = clock.now();
+	ThreadPool pool {std::max(std::thread::hardware_concurrency(), 1u)};
+	const Scene scene = load_scene(in_path, manifest, pool);
+	write_lxv(out_path, scene);
+	std::chrono::duration<double> duration = std::chrono::duration_cast<std::chrono::duration<double>>(clock.now() - time_start);
+
+	stx::log[stx::INFO] << "Scene";
+	stx::log.indent_in();
+	stx::log[stx::WRITE] << "Size:       " << scene.size;
+	stx::log[stx::WRITE] << "Bricks:     " << scene.brick_data.size() / Scene::brick_volume - 1 << " of " << scene.brick_index.size() << " stored";
+	stx::log.indent_out();
+	stx::log[stx::INFO] << "Written " << out_path << " in " << duration;
+}
@@ -5,166 +5,404 @@
 #include <chrono>
 #include <span>
 #include <iomanip>
-#include <future>
+#include <thread>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <optional>
 
-#include "stdxx/matrix.hxx"
 #include "stdxx/log.hxx"
 #include "stdxx/json.hxx"
 
-#include "stb/stb_image_write.h"
-
-#include "ray_cast.hxx"
+#include "render.hxx"
 #include "load_scene.hxx"
 #include "load_camera.hxx"
 #include "load_resolution.hxx"
+#include "load_quality.hxx"
+#include "ThreadPool.hxx"
+#include "ImageWriter.hxx"
+#include "write_image.hxx"
+#include "SceneCache.hxx"
 
 #include "Scene.hxx"
 #include "Camera.hxx"
-#include "angle.hxx"
+#include "CameraPath.hxx"
+#include "Options.hxx"
 
 
-stx::vector3f reflect(stx::vector3f normal, stx::vector3f ray) {
-	return ray - 2 * stx::dot(ray, normal) * normal;
+// Command line options override the settings in options.
+Options parse_options(std::span<char *> rest, Options options = {}) {
+	for(std::size_t i = 0; i < rest.size(); ++i) {
+		const std::string_view option {rest[i]};
+		if(option == "--quiet") {
+			options.quiet = true;
+		}
+		else if(option == "--threaded") {
+			options.threads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		else if(option == "--threads" && i + 1 < rest.size()) {
+			options.threads = std::max(std::stoul(rest[++i]), 1ul);
+		}
+		else if(option == "--tile-size" && i + 1 < rest.size()) {
+			options.tile_size = std::max(std::stoul(rest[++i]), 1ul);
+		}
+		else if(option == "--packet" && i + 1 < rest.size()) {
+			options.packet_size = std::stoul(rest[++i]);
+			if(options.packet_size != 1 && options.packet_size != 4 && options.packet_size != 8 && options.packet_size != 16) {
+				throw std::runtime_error{"--packet must be 1, 4, 8 or 16"};
+			}
+		}
+		else if(option == "--seed" && i + 1 < rest.size()) {
+			options.seed = std::stoull(rest[++i]);
+		}
+		else if(option == "--spp" && i + 1 < rest.size()) {
+			options.samples = std::max(std::stoul(rest[++i]), 1ul);
+		}
+		else if(option == "--max-bounce" && i + 1 < rest.size()) {
+			options.max_bounce = std::max(std::stoul(rest[++i]), 1ul);
+		}
+		else if(option == "--split" && i + 1 < rest.size()) {
+			options.split = std::max(std::stoul(rest[++i]), 1ul);
+		}
+		else if(option == "--max-distance" && i + 1 < rest.size()) {
+			options.max_distance = std::stof(rest[++i]);
+			if(!(options.max_distance > 0)) throw std::runtime_error{"--max-distance must be positive"};
+		}
+		else if(option == "--progressive") {
+			options.progressive = true;
+		}
+		else if(option == "--time-budget" && i + 1 < rest.size()) {
+			options.time_budget = std::stod(rest[++i]);
+		}
+		else if(option == "--flush-interval" && i + 1 < rest.size()) {
+			options.flush_interval = std::stod(rest[++i]);
+		}
+		else if(option == "--flush-passes" && i + 1 < rest.size()) {
+			options.flush_passes = std::stoul(rest[++i]);
+		}
+		else if(option == "--adaptive" && i + 1 < rest.size()) {
+			options.adaptive_threshold = std::stof(rest[++i]);
+		}
+		else if(option == "--adaptive-min-spp" && i + 1 < rest.size()) {
+			options.adaptive_min_samples = std::max(std::stoul(rest[++i]), 2ul);
+		}
+		else if(option == "--tonemap" && i + 1 < rest.size()) {
+			const std::string_view name {rest[++i]};
+			if(name == "clamp") options.tonemap = Tonemap::clamp;
+			else if(name == "reinhard") options.tonemap = Tonemap::reinhard;
+			else if(name == "aces") options.tonemap = Tonemap::aces;
+			else throw std::runtime_error{"--tonemap must be clamp, reinhard or aces"};
+		}
+		else if(option == "--exposure" && i + 1 < rest.size()) {
+			options.exposure = std::stof(rest[++i]);
+		}
+		else if(option == "--png-level" && i + 1 < rest.size()) {
+			options.png_level = std::clamp(std::stoi(rest[++i]), 1, 9);
+		}
+		else if(option == "--encode-threads" && i + 1 < rest.size()) {
+			options.encode_threads = std::max(std::stoul(rest[++i]), 1ul);
+		}
+		else if(option == "--cache-size" && i + 1 < rest.size()) {
+			options.cache_size = std::max(std::stoul(rest[++i]), 1ul);
+		}
+		else if(option == "--integrator" && i + 1 < rest.size()) {
+			const std::string_view name {rest[++i]};
+			if(name == "recursive") options.integrator = Integrator::recursive;
+			else if(name == "path") options.integrator = Integrator::path;
+			else throw std::runtime_error{"--integrator must be recursive or path"};
+		}
+	}
+	return options;
 }
 
 
 
-std::tuple<float, float, float> render_rec(std::size_t rec_counter, bool loose_energy, std::size_t split, const Scene & scene, stx::position3f start, stx::vector3f dir) {
-	if(rec_counter <= 0) return {0,0,0};
-	auto end = ray_cast(stx::vector3f{start}, stx::normalized(dir), [&] (const Intersection & intersection) {
-		const Voxel & v = scene(intersection.coords.x, intersection.coords.y, intersection.coords.z);
-		return v.a == 0;
-	});
+// Splits "small,medium,large" into its config names.
+std::vector<std::string> parse_configs(std::string_view list) {
+	std::vector<std::string> configs;
+	while(true) {
+		const std::size_t comma = list.find(',');
+		const std::string_view name = list.substr(0, comma);
+		if(!name.empty()) configs.push_back(std::string{name});
+		if(comma == std::string_view::npos) break;
+		list.remove_prefix(comma + 1);
+	}
+	return configs;
+}
+
+
+
+// A single config writes to out_path, several configs write to <stem>_<config><extension> next to it.
+std::filesystem::path output_path(const std::filesystem::path & out_path, const std::string & config, bool batch) {
+	if(!batch) return out_path;
+	return out_path.parent_path() / (out_path.stem().string() + "_" + config + out_path.extension().string());
+}
+
+
+
+// Animations append the zero padded frame number to the file name.
+std::filesystem::path frame_path(const std::filesystem::path & out_path, std::size_t frame) {
+	std::ostringstream name;
+	name << out_path.stem().string() << "_" << std::setw(4) << std::setfill('0') << frame << out_path.extension().string();
+	return out_path.parent_path() / name.str();
+}
+
+
+
+// --position x y z, --rotation x y z and --fov f replace parts of the first keyframe
+// and render it as a still. Without them the path is returned unchanged.
+CameraPath override_camera(std::span<char *> rest, CameraPath path) {
+	CameraKeyframe keyframe = path.keyframes.front();
+	bool overridden = false;
+	for(std::size_t i = 0; i < rest.size(); ++i) {
+		const std::string_view option {rest[i]};
+		if(option == "--position" && i + 3 < rest.size()) {
+			keyframe.position = {std::stof(rest[i + 1]), std::stof(rest[i + 2]), std::stof(rest[i + 3])};
+			overridden = true;
+			i += 3;
+		}
+		else if(option == "--rotation" && i + 3 < rest.size()) {
+			keyframe.rotation = {std::stof(rest[i + 1]), std::stof(rest[i + 2]), std::stof(rest[i + 3])};
+			overridden = true;
+			i += 3;
+		}
+		else if(option == "--fov" && i + 1 < rest.size()) {
+			keyframe.fov = std::stof(rest[++i]);
+			overridden = true;
+		}
+	}
+	if(!overridden) return path;
+	keyframe.frame = 0;
+	return CameraPath{{keyframe}};
+}
+
+
+
+// Quality settings come from the config with the command line taking precedence.
+// Returns the paths of the images written, one per frame.
+std::vector<std::filesystem::path> render_config(const stx::json::iterator manifest, const std::string & config, const std::filesystem::path & out_path, const Scene & scene, std::span<char *> args, ThreadPool & pool, ImageWriter & writer) {
+	const Options options = parse_options(args, load_quality(manifest, config, Options{}));
+	const stx::size2u resolution = load_resolution(manifest, config);
+	const CameraPath camera_path = override_camera(args, load_camera_path(manifest, config));
+	const std::size_t frames = camera_path.frames();
+	const bool animated = camera_path.animated();
+	const ImageFormat format = image_format(out_path);
+
+	stx::log[stx::INFO] << "Config " << config;
+	stx::log.indent_in();
+
+	stx::log[stx::INFO] << "Camera";
+	stx::log.indent_in();
+	if(animated) {
+		stx::log[stx::WRITE] << "Keyframes:  " << camera_path.keyframes.size();
+		stx::log[stx::WRITE] << "Frames:     " << frames;
+	}
+	else {
+		const Camera camera = camera_path(0);
+		stx::log[stx::WRITE] << "Position:   " << camera.position;
+		stx::log[stx::WRITE] << "Quaternion: " << camera.rotation;
+		stx::log[stx::WRITE] << "FOV:        " << camera.fov;
+	}
+	stx::log.indent_out();
 
-	float bounce_r = 0;
-	float bounce_g = 0;
-	float bounce_b = 0;
+	stx::log[stx::INFO] << "Quality";
+	stx::log.indent_in();
+	stx::log[stx::WRITE] << "Samples:      " << options.samples;
+	stx::log[stx::WRITE] << "Max bounce:   " << options.max_bounce;
+	stx::log[stx::WRITE] << "Split:        " << options.split;
+	stx::log[stx::WRITE] << "Max distance: " << options.max_distance;
+	if(options.time_budget > 0) {
+		stx::log[stx::WRITE] << "Time budget:  " << options.time_budget << "s";
+	}
+	stx::log.indent_out();
 
-	const Voxel & v = scene(end.coords.x, end.coords.y, end.coords.z);
-	float brightness = std::clamp(stx::dot(end.normal, stx::normalized(stx::vector3f{0,-0.5f,1})), 0.1f, 1.f);
+	stx::log[stx::INFO] << "Output";
+	stx::log.indent_in();
+	stx::log[stx::WRITE] << "Path:       " << out_path;
+	stx::log[stx::WRITE] << "Format:     " << to_string(format);
+	stx::log[stx::WRITE] << "Resolution: " << resolution;
+	stx::log.indent_out();
 
-	for(std::size_t i = 0; i < split; ++i) {
-		const float dx = (rand() % 1000) / 500.f - 1.f;
-		const float dy = (rand() % 1000) / 500.f - 1.f;
-		const float dz = (rand() % 1000) / 500.f - 1.f;
-		const stx::vector3f rand_dir{dx, dy, dz};
-		const stx::vector3f hemi_dir = stx::dot(end.normal, rand_dir) >= 0 ? rand_dir : -rand_dir;
+	std::vector<std::filesystem::path> paths;
+	for(std::size_t f = 0; f < frames; ++f) {
+		const Camera camera = camera_path(f);
+		const std::filesystem::path path = animated ? frame_path(out_path, f) : out_path;
+		paths.push_back(path);
+
+		stx::log[stx::INFO] << "Rendering...";
+		if(animated) stx::log[stx::WRITE] << "Frame " << f + 1 << "/" << frames;
+		std::chrono::steady_clock clock;
+		std::chrono::time_point time_start = clock.now();
+		Framebuffer frame = options.progressive
+			? render_progressive(resolution, scene, camera, options, pool, [&] (const Framebuffer & frame, std::size_t) {
+				// The last flush is the final image. The writer keeps writes to one path in order.
+				writer.push(path, frame, options.tonemap, options.exposure, options.png_level);
+			})
+			: render(resolution, scene, camera, options, pool);
+		std::chrono::time_point time_end= clock.now();
+		std::chrono::duration<double> duration = std::chrono::duration_cast<std::chrono::duration<double>>(time_end - time_start);
+		stx::log[stx::INFO] << "Renering done. Duration: " << duration;
+		if constexpr (stats::enabled) {
+			stats::log(frame.stats);
+		}
 
-		const stx::vector3f new_dir = stx::normalized(hemi_dir);
-		const auto [ bounce_r_comp, bounce_g_comp, bounce_b_comp ] = render_rec(rec_counter-1, split, true, scene, end.point, new_dir);
-		bounce_r += bounce_r_comp / split;
-		bounce_g += bounce_g_comp / split;
-		bounce_b += bounce_b_comp / split;
+		// Encoded and written while the next frame or config renders.
+		if(!options.progressive) {
+			stx::log[stx::INFO] << "Writing image...";
+			writer.push(path, std::move(frame), options.tonemap, options.exposure, options.png_level);
+		}
 	}
 
-	return {
-		(v.r * (brightness + 0.5f * bounce_r)) * (loose_energy ? (1.f - end.depth) : 1.f),
-		(v.g * (brightness + 0.5f * bounce_g)) * (loose_energy ? (1.f - end.depth) : 1.f),
-		(v.b * (brightness + 0.5f * bounce_b)) * (loose_energy ? (1.f - end.depth) : 1.f),
-	};
+	stx::log.indent_out();
+	return paths;
 }
 
 
 
-struct Options {
-	bool threaded = false;
-};
+void log_options(const Options & options) {
+	stx::log[stx::INFO] << "Options";
+	stx::log.indent_in();
+	stx::log[stx::WRITE] << "--threads:   " << options.threads;
+	stx::log[stx::WRITE] << "--tile-size: " << options.tile_size;
+	stx::log[stx::WRITE] << "--packet:    " << options.packet_size;
+	stx::log[stx::WRITE] << "--seed:      " << options.seed;
+	stx::log[stx::WRITE] << "--integrator: " << (options.integrator == Integrator::path ? "path" : "recursive");
+	if(options.adaptive_threshold > 0) {
+		stx::log[stx::WRITE] << "--adaptive:         " << options.adaptive_threshold;
+		stx::log[stx::WRITE] << "--adaptive-min-spp: " << options.adaptive_min_samples;
+	}
+	stx::log[stx::WRITE] << "--tonemap:   " << to_string(options.tonemap);
+	stx::log[stx::WRITE] << "--exposure:  " << options.exposure;
+	stx::log[stx::WRITE] << "--png-level: " << options.png_level;
+	stx::log[stx::WRITE] << "--encode-threads: " << options.encode_threads;
+	stx::log[stx::WRITE] << "--progressive: " << std::boolalpha << options.progressive;
+	if(options.progressive) {
+		stx::log[stx::WRITE] << "--flush-interval: " << options.flush_interval << "s";
+		stx::log[stx::WRITE] << "--flush-passes:   " << options.flush_passes;
+	}
+	stx::log.indent_out();
+}
 
 
 
-Options parse_options(std::span<char *> rest) {
-	Options options;
-	for(char * option : rest) {
-		if(std::string_view{option} == "--threaded") {
-			options.threaded = true;
+// Options that size the thread pool, the image writer or the scene cache of the server.
+// They are fixed at startup, so a job passing one is rejected.
+void reject_server_options(std::span<const std::string> words) {
+	for(const std::string & word : words) {
+		if(word == "--threads" || word == "--threaded" || word == "--encode-threads" || word == "--cache-size") {
+			throw std::runtime_error{word + " can only be given when the server starts"};
 		}
 	}
-	return options;
 }
 
 
 
-std::vector<std::uint8_t> render(const stx::size2u resolution, const Scene & scene, const Camera & camera, const Options & options) {
-	std::vector<std::uint8_t> data;
-	data.resize(resolution.x * resolution.y * 4);
-	const float fov = 45.f;
-	const stx::position3f start = camera.position;
-	const stx::quatf orientation = camera.rotation;
-
-	constexpr static std::size_t max_bounce = 4;
-	constexpr static std::size_t split = 3;
-
-	const auto f = [&resolution, &scene, &camera, &start, &data](std::int32_t y_start, std::int32_t y_end) {
-		for(std::int32_t y = y_start; y < y_end; ++y){
-			for(std::int32_t x = 0; x < resolution.x; ++x){
-				const float dx = (static_cast<float>(x) / static_cast<float>(resolution.x)) * 2.f - 1.f;
-				const float dy = (static_cast<float>(y) / static_cast<float>(resolution.y)) * 2.f - 1.f;
-				const stx::vector3f default_dir {dx, 1, -dy};
-				const stx::vector3f dir = stx::dim_cast<3>(stx::matrix4f::from_quat(camera.rotation) * stx::dim_cast<4>(default_dir));
-				const auto [r,g,b] = render_rec(max_bounce, false, split, scene, start, dir);
-				const std::size_t i = 4 * (y * resolution.x + x);
-				data[i + 0] = static_cast<std::uint8_t>(std::clamp(r * 255.f, 0.f, 255.f));
-				data[i + 1] = static_cast<std::uint8_t>(std::clamp(g * 255.f, 0.f, 255.f));
-				data[i + 2] = static_cast<std::uint8_t>(std::clamp(b * 255.f, 0.f, 255.f));
-				data[i + 3] = 255;
+// Splits a job line at whitespace. Paths containing spaces are not supported.
+std::vector<std::string> split_words(const std::string & line) {
+	std::vector<std::string> words;
+	std::istringstream stream {line};
+	for(std::string word; stream >> word;) {
+		words.push_back(std::move(word));
+	}
+	return words;
+}
+
+
+
+// Reads one job per line from stdin:
+//     render <project> <config> <output_path> [options...]
+//     quit
+// Job options follow the server options and take precedence, --position, --rotation and --fov
+// override the config camera. --threads, --threaded, --encode-threads and --cache-size are
+// server options, a job giving one of them is answered with an error. Each job is answered on stdout with
+// "ok <path>..." listing every image written, one per frame for animated configs, or "error <message>".
+// The log goes to stderr.
+// Projects stay loaded between jobs, all jobs share one thread pool and image writer.
+int serve(std::span<char *> args) {
+	stx::log.register_output(std::cerr);
+
+	const Options options = parse_options(args);
+	stx::log[stx::WRITE] << "Luxite: Voxel Raytracer (c) 2024 Sera K. Litsch ";
+	log_options(options);
+	stx::log[stx::WRITE] << "--cache-size: " << options.cache_size;
+
+	ThreadPool pool {options.threads};
+	ImageWriter writer {options.encode_threads};
+	SceneCache cache {options.cache_size};
+
+	for(std::string line; std::getline(std::cin, line);) {
+		const std::vector<std::string> words = split_words(line);
+		if(words.empty()) continue;
+		if(words[0] == "quit") break;
+
+		try {
+			if(words[0] != "render" || words.size() < 4) {
+				throw std::runtime_error{"Usage: render <project> <config> <output_path> [options...]"};
 			}
-			if(y % (resolution.y / 20) == 0) {
-				const float percentage = (static_cast<float>(y - y_start) / (y_end - y_start)) * 100;
-				std::cout 
-					<< std::round(percentage) << "% in chunk"
-					<< "["<< y_start << ", " << y_end << "]"
-					<< "\n";
-			} 
-		}
-	};
+			const std::filesystem::path out_path {words[3]};
+			reject_server_options(std::span{words}.subspan(4));
 
-	if(options.threaded) {
-		constexpr static std::size_t num_of_threads = 4;
-		std::array<std::future<void>, num_of_threads> chunks;
+			std::vector<char *> job_args {std::begin(args), std::end(args)};
+			for(std::size_t i = 4; i < words.size(); ++i) {
+				job_args.push_back(const_cast<char *>(words[i].c_str()));
+			}
 
-		for(std::size_t i = 0; i < num_of_threads; ++i) {
-			chunks[i] = std::async(std::launch::async, [&, i] () {
-				const std::int32_t y_start = resolution.y * i / num_of_threads;
-				const std::int32_t y_end   = resolution.y * (i + 1) / num_of_threads;
-				return f(y_start, y_end);
-			});
+			const std::shared_ptr<const Project> project = cache.get(words[1], pool);
+			if(out_path.has_parent_path()) {
+				std::filesystem::create_directories(out_path.parent_path());
+			}
+			const std::vector<std::filesystem::path> paths = render_config(stx::json::iterator{project->manifest}, words[2], out_path, project->scene, job_args, pool, writer);
+			writer.wait();
+			std::cout << "ok";
+			for(const std::filesystem::path & path : paths) {
+				std::cout << " " << path.string();
+			}
+			std::cout << std::endl;
 		}
-
-		for(const std::future<void> & chunk : chunks) {
-			chunk.wait();
+		catch(const std::exception & error) {
+			stx::log[stx::ERROR] << error.what();
+			std::cout << "error " << error.what() << std::endl;
 		}
 	}
-	else {
-		f(0, resolution.y);
-	}
 
-	return data;
+	writer.wait();
+	return EXIT_SUCCESS;
 }
 
 
 
 int main(int argc, char ** argv) {
+	if(argc >= 2 && std::string_view{argv[1]} == "--server") {
+		return serve(std::span<char*>{argv + 2, argv + argc});
+	}
+
 	stx::log.register_output(std::cout);
 
 
 	if(argc < 4) {
 		stx::log[stx::ERROR] 
 			<< "To few arguments were provided. Usage: "
-			<< argv[0] << " <project> <config> <output_path>";
+			<< argv[0] << " <project> <config>[,<config>...] <output_path>"
+			<< " or " << argv[0] << " --server [options...]";
 		return EXIT_FAILURE;
 	}
 
     const std::filesystem::path in_path {argv[1]};
-	const std::string config = argv[2];
+	const std::vector<std::string> configs = parse_configs(argv[2]);
     const std::filesystem::path out_path {argv[3]};
-	const Options options = parse_options(std::span<char*>{argv + 4, argv + argc});
+	const std::span<char*> args {argv + 4, argv + argc};
+	const Options options = parse_options(args);
+
+	if(configs.empty()) {
+		stx::log[stx::ERROR] << "No config was provided.";
+		return EXIT_FAILURE;
+	}
 
     const stx::json::node data = stx::json::from_file(in_path/"manifest.json");
     const stx::json::iterator manifest {data};
 
-	const Scene scene = load_scene(in_path, manifest);
-	const stx::size2u resolution = load_resolution(manifest, config);
-	const Camera camera = load_camera(manifest, config);
+	ThreadPool pool {options.threads};
+	const Scene scene = load_scene(in_path, manifest, pool);
 
 	stx::log[stx::WRITE] << "Luxite: Voxel Raytracer (c) 2024 Sera K. Litsch ";
 
@@ -172,40 +410,23 @@ int main(int argc, char ** argv) {
 	stx::log.indent_in();
 	stx::log[stx::WRITE] << "Size:       " << scene.size;
 	stx::log.indent_out();
-	
-	stx::log[stx::INFO] << "Camera";
-	stx::log.indent_in();
-	stx::log[stx::WRITE] << "Position:   " << camera.position;
-	stx::log[stx::WRITE] << "Quaternion: " << camera.rotation;
-	stx::log.indent_out();
 
-	stx::log[stx::INFO] << "Options";
-	stx::log.indent_in();
-	stx::log[stx::WRITE] << "--threaded: " << std::boolalpha << options.threaded;
-	stx::log.indent_out();
-
-	stx::log[stx::INFO] << "Output";
-	stx::log.indent_in();
-	stx::log[stx::WRITE] << "Format:     " << "PNG";
-	stx::log[stx::WRITE] << "Resolution: " << resolution;
-	stx::log.indent_out();
-
-	stx::log[stx::INFO] << "Rendering...";
-	std::chrono::steady_clock clock;
-	std::chrono::time_point time_start = clock.now();
-	auto rendered_image = render(resolution, scene, camera, options);
-	std::chrono::time_point time_end= clock.now();
-	std::chrono::duration<double> duration = std::chrono::duration_cast<std::chrono::duration<double>>(time_end - time_start);
-	stx::log[stx::INFO] << "Renering done. Duration: " << duration;
+	log_options(options);
 
-
-	stx::log[stx::INFO] << "Writing image...";
 	if(std::filesystem::create_directory(out_path.parent_path())) {
 		stx::log[stx::INFO] 
 			<< "Output directory "
 			<< std::filesystem::canonical(out_path.parent_path())
 			<< " was created.";
 	}
-	stbi_write_png(out_path.c_str(), resolution.x, resolution.y, 4, rendered_image.data(), resolution.x * 4);
+
+	ImageWriter writer {options.encode_threads};
+
+	const bool batch = configs.size() > 1;
+	for(const std::string & config : configs) {
+		render_config(manifest, config, output_path(out_path, config, batch), scene, args, pool, writer);
+	}
+
+	writer.wait();
 	stx::log[stx::INFO] << "Writing image done!";
 }
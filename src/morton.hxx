@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+// Spreads the lower 21 bits of v so two zero bits follow each bit.
+constexpr std::uint64_t morton_spread(std::uint64_t v) {
+	v &= 0x1fffff;
+	v = (v | v << 32) & 0x1f00000000ffff;
+	v = (v | v << 16) & 0x1f0000ff0000ff;
+	v = (v | v <<  8) & 0x100f00f00f00f00f;
+	v = (v | v <<  4) & 0x10c30c30c30c30c3;
+	v = (v | v <<  2) & 0x1249249249249249;
+	return v;
+}
+
+
+
+// Z-order index of a 3D coordinate with up to 21 bits per axis.
+constexpr std::uint64_t morton_encode(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+	return morton_spread(x) | (morton_spread(y) << 1) | (morton_spread(z) << 2);
+}
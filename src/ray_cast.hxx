@@ -1,7 +1,16 @@
 #pragma once
+#include <tuple>
+#include <cmath>
+#include <optional>
 #include "stdxx/vector.hxx"
 #include "Voxel.hxx"
 #include "Intersection.hxx"
+#include "Box.hxx"
+
+// Default distance after which a ray counts as lost, see Options::max_distance.
+constexpr inline float ray_max_dist = 100.f;
+
+
 
 auto squared(auto x) {
 	return x * x;
@@ -12,7 +21,79 @@ auto div_squared(auto a, auto b) {
 	return squared(a / b);
 }
 
-Intersection ray_cast(stx::vector3f start, stx::vector3f dir, auto process_voxel) {
+// Places the ray on one axis at distance dist.
+// If the ray crosses a voxel border at dist the coordinate is set to the voxel before the border,
+// so the next step enters the voxel behind it.
+inline void ray_place_axis(float start, float dir, float scale, std::int32_t step, float dist, std::optional<std::int32_t> crossed, std::int32_t & coord, float & ray_length) {
+	if(crossed) {
+		coord = step > 0 ? *crossed - 1 : *crossed;
+		ray_length = dist;
+		return;
+	}
+	const float p = start + dir * dist;
+	coord = static_cast<std::int32_t>(std::floor(p));
+	ray_length = dist + (step > 0 ? (coord + 1 - p) : (p - coord)) * scale;
+}
+
+
+
+// Exit distance of the ray from box.
+// Returns the distance and the border plane on the axis the ray leaves through.
+inline std::tuple<float, char, std::int32_t> ray_exit(stx::vector3f start, stx::vector3f dir, stx::position3i step, const Box & box) {
+	const auto exit_axis = [] (float s, float d, std::int32_t step, std::int32_t min, std::int32_t max) {
+		const std::int32_t plane = step > 0 ? max + 1 : min;
+		if(d == 0) return std::pair{INFINITY, plane};
+		return std::pair{(plane - s) / d, plane};
+	};
+	const auto [tx, px] = exit_axis(start.x, dir.x, step.x, box.min.x, box.max.x);
+	const auto [ty, py] = exit_axis(start.y, dir.y, step.y, box.min.y, box.max.y);
+	const auto [tz, pz] = exit_axis(start.z, dir.z, step.z, box.min.z, box.max.z);
+	if(tx <= ty && tx <= tz) return {tx, 'x', px};
+	if(ty <= tz)             return {ty, 'y', py};
+	return                          {tz, 'z', pz};
+}
+
+
+
+// Slab test of the ray against box.
+// Returns the distances at which the ray enters and leaves the box and the border plane it enters through.
+// The entry distance is negative if start lies inside the box.
+// Returns nothing if the ray misses the box or the box lies behind start.
+inline std::optional<std::tuple<float, float, char, std::int32_t>> ray_clip(stx::vector3f start, stx::vector3f dir, const Box & box) {
+	float enter = -INFINITY;
+	float exit = INFINITY;
+	char enter_axis = 'x';
+	std::int32_t enter_plane = 0;
+	const auto clip_axis = [&] (float s, float d, std::int32_t min, std::int32_t max, char axis) {
+		if(d == 0) return s >= min && s < max + 1;
+		const std::int32_t near = d > 0 ? min : max + 1;
+		const std::int32_t far  = d > 0 ? max + 1 : min;
+		const float t_near = (near - s) / d;
+		const float t_far  = (far  - s) / d;
+		if(t_near > enter) {
+			enter = t_near;
+			enter_axis = axis;
+			enter_plane = near;
+		}
+		exit = std::min(exit, t_far);
+		return true;
+	};
+	if(!clip_axis(start.x, dir.x, box.min.x, box.max.x, 'x')) return std::nullopt;
+	if(!clip_axis(start.y, dir.y, box.min.y, box.max.y, 'y')) return std::nullopt;
+	if(!clip_axis(start.z, dir.z, box.min.z, box.max.z, 'z')) return std::nullopt;
+	if(!(enter < exit) || exit <= 0) return std::nullopt;
+	return std::tuple{enter, exit, enter_axis, enter_plane};
+}
+
+
+
+// Marches along a normalized ray voxel by voxel until process_voxel returns false.
+// After every transparent voxel empty_box may return a region known to be transparent.
+// The ray then jumps straight to the border of that region.
+// With bounds the ray is clipped to that box first: a ray missing it is lost without a single step,
+// a ray starting outside begins at its entry point and every ray is lost once it has left the box.
+// Rays are lost after max_dist as well, the depth of an intersection is its distance relative to max_dist.
+Intersection ray_cast(stx::vector3f start, stx::vector3f dir, auto process_voxel, auto empty_box, const std::optional<Box> & bounds, float max_dist = ray_max_dist) {
 	const stx::vector3f scale {
 		std::sqrt(1                         + div_squared(dir.y, dir.x) + div_squared(dir.z, dir.x)),
 		std::sqrt(div_squared(dir.x, dir.y) + 1                         + div_squared(dir.z, dir.y)),
@@ -50,11 +131,33 @@ Intersection ray_cast(stx::vector3f start, stx::vector3f dir, auto process_voxel
 		ray_length_1d.z = (voxel_coord.z + 1 - start.z) * scale.z;
 	}
 
-	const float max_dist = 100.f;
+	float end_dist = max_dist;
 	bool running = true;
 	float dist = 0.f;
 	stx::vector3f normal;
-	while(running && (dist < max_dist)) {
+
+	if(bounds) {
+		const auto clip = ray_clip(start, dir, *bounds);
+		if(!clip || std::get<0>(*clip) >= max_dist) {
+			return Intersection {
+				.coords = stx::position3i{start + dir * max_dist},
+				.point = stx::position3f{start + dir * max_dist},
+				.normal = {0,0,0},
+				.depth = 1.f,
+				.lost = true,
+			};
+		}
+		const auto [enter_dist, exit_dist, axis, plane] = *clip;
+		end_dist = std::min(exit_dist, max_dist);
+		if(enter_dist > 0) {
+			ray_place_axis(start.x, dir.x, scale.x, step.x, enter_dist, axis == 'x' ? std::optional{plane} : std::nullopt, voxel_coord.x, ray_length_1d.x);
+			ray_place_axis(start.y, dir.y, scale.y, step.y, enter_dist, axis == 'y' ? std::optional{plane} : std::nullopt, voxel_coord.y, ray_length_1d.y);
+			ray_place_axis(start.z, dir.z, scale.z, step.z, enter_dist, axis == 'z' ? std::optional{plane} : std::nullopt, voxel_coord.z, ray_length_1d.z);
+			dist = enter_dist;
+		}
+	}
+
+	while(running && (dist < end_dist)) {
 
 		const float shortest = std::min({
 			ray_length_1d.x,
@@ -88,6 +191,18 @@ Intersection ray_cast(stx::vector3f start, stx::vector3f dir, auto process_voxel
 			.depth = dist / max_dist,
 			.lost = false,
 		});
+
+		if(!running) break;
+
+		const std::optional<Box> box = empty_box(voxel_coord);
+		if(!box) continue;
+
+		const auto [exit_dist, axis, plane] = ray_exit(start, dir, step, *box);
+		if(!(exit_dist > dist)) continue;
+		ray_place_axis(start.x, dir.x, scale.x, step.x, exit_dist, axis == 'x' ? std::optional{plane} : std::nullopt, voxel_coord.x, ray_length_1d.x);
+		ray_place_axis(start.y, dir.y, scale.y, step.y, exit_dist, axis == 'y' ? std::optional{plane} : std::nullopt, voxel_coord.y, ray_length_1d.y);
+		ray_place_axis(start.z, dir.z, scale.z, step.z, exit_dist, axis == 'z' ? std::optional{plane} : std::nullopt, voxel_coord.z, ray_length_1d.z);
+		dist = exit_dist;
 	}
 
 	return Intersection {
@@ -97,4 +212,18 @@ Intersection ray_cast(stx::vector3f start, stx::vector3f dir, auto process_voxel
 		.depth = dist / max_dist,
 		.lost = running,
 	};
-}
\ No newline at end of file
+}
+
+
+
+Intersection ray_cast(stx::vector3f start, stx::vector3f dir, auto process_voxel, auto empty_box) {
+	return ray_cast(start, dir, process_voxel, empty_box, std::nullopt);
+}
+
+
+
+Intersection ray_cast(stx::vector3f start, stx::vector3f dir, auto process_voxel) {
+	return ray_cast(start, dir, process_voxel, [] (const stx::position3i &) {
+		return std::optional<Box>{};
+	});
+}
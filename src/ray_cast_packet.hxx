@@ -0,0 +1,189 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <bit>
+#include "ray_cast.hxx"
+#include "Stats.hxx"
+
+// N rays sharing one origin, stored as one array per component.
+template<std::size_t N>
+struct RayPacket {
+	stx::vector3f start;
+	std::array<float, N> dir_x;
+	std::array<float, N> dir_y;
+	std::array<float, N> dir_z;
+	std::array<bool, N> active;
+};
+
+
+
+// Picks a where mask is 1 and b where it is 0, using bit operations only.
+// GCC turns a ?: between values it loads and stores into branches or masked stores
+// and then gives up on vectorizing, these stay plain and/or over the lanes.
+inline std::int32_t lane_select(std::int32_t mask, std::int32_t a, std::int32_t b) {
+	return (a & -mask) | (b & (mask - 1));
+}
+
+inline float lane_select(std::int32_t mask, float a, float b) {
+	return std::bit_cast<float>(lane_select(mask, std::bit_cast<std::int32_t>(a), std::bit_cast<std::int32_t>(b)));
+}
+
+
+
+// Marches all active rays of a packet in lock step.
+// The DDA step of all lanes is written as selects over 32 bit lanes, so the compiler vectorizes it
+// for whatever instruction set it targets. The voxel lookups and box skips are done per lane.
+// Lanes leave the packet once they hit an opaque voxel or pass max_dist.
+// With bounds every lane is clipped to that box like in ray_cast.
+template<std::size_t N>
+std::array<Intersection, N> ray_cast_packet(const RayPacket<N> & rays, auto is_transparent, auto empty_box, const std::optional<Box> & bounds, float max_dist = ray_max_dist) {
+	const stx::vector3f start = rays.start;
+
+	alignas(64) std::array<float, N> scale_x, scale_y, scale_z;
+	alignas(64) std::array<float, N> length_x, length_y, length_z;
+	alignas(64) std::array<std::int32_t, N> step_x, step_y, step_z;
+	alignas(64) std::array<std::int32_t, N> coord_x, coord_y, coord_z;
+	alignas(64) std::array<float, N> dist;
+	alignas(64) std::array<float, N> end_dist;
+	alignas(64) std::array<std::int32_t, N> axis;
+	// 0 or 1 per lane. Integers instead of bool, so the step loop has no short circuits.
+	alignas(64) std::array<std::int32_t, N> running;
+	std::array<bool, N> lost;
+	lost.fill(true);
+	for(std::size_t i = 0; i < N; ++i) {
+		running[i] = rays.active[i];
+	}
+
+	const std::int32_t start_x = static_cast<std::int32_t>(start.x);
+	const std::int32_t start_y = static_cast<std::int32_t>(start.y);
+	const std::int32_t start_z = static_cast<std::int32_t>(start.z);
+
+	for(std::size_t i = 0; i < N; ++i) {
+		const float dx = rays.dir_x[i];
+		const float dy = rays.dir_y[i];
+		const float dz = rays.dir_z[i];
+		scale_x[i] = std::sqrt(1                   + div_squared(dy, dx) + div_squared(dz, dx));
+		scale_y[i] = std::sqrt(div_squared(dx, dy) + 1                   + div_squared(dz, dy));
+		scale_z[i] = std::sqrt(div_squared(dx, dz) + div_squared(dy, dz) + 1                  );
+		step_x[i] = dx < 0 ? -1 : +1;
+		step_y[i] = dy < 0 ? -1 : +1;
+		step_z[i] = dz < 0 ? -1 : +1;
+		coord_x[i] = start_x;
+		coord_y[i] = start_y;
+		coord_z[i] = start_z;
+		length_x[i] = (dx < 0 ? start.x - start_x : start_x + 1 - start.x) * scale_x[i];
+		length_y[i] = (dy < 0 ? start.y - start_y : start_y + 1 - start.y) * scale_y[i];
+		length_z[i] = (dz < 0 ? start.z - start_z : start_z + 1 - start.z) * scale_z[i];
+		dist[i] = 0.f;
+		end_dist[i] = max_dist;
+		axis[i] = 0;
+
+		if(!bounds || !running[i]) continue;
+		const stx::vector3f dir {dx, dy, dz};
+		const auto clip = ray_clip(start, dir, *bounds);
+		if(!clip || std::get<0>(*clip) >= max_dist) {
+			const stx::position3i end = stx::position3i{start + dir * max_dist};
+			coord_x[i] = end.x;
+			coord_y[i] = end.y;
+			coord_z[i] = end.z;
+			dist[i] = max_dist;
+			running[i] = false;
+			continue;
+		}
+		const auto [enter_dist, exit_dist, enter_axis, plane] = *clip;
+		end_dist[i] = std::min(exit_dist, max_dist);
+		if(enter_dist > 0) {
+			ray_place_axis(start.x, dx, scale_x[i], step_x[i], enter_dist, enter_axis == 'x' ? std::optional{plane} : std::nullopt, coord_x[i], length_x[i]);
+			ray_place_axis(start.y, dy, scale_y[i], step_y[i], enter_dist, enter_axis == 'y' ? std::optional{plane} : std::nullopt, coord_y[i], length_y[i]);
+			ray_place_axis(start.z, dz, scale_z[i], step_z[i], enter_dist, enter_axis == 'z' ? std::optional{plane} : std::nullopt, coord_z[i], length_z[i]);
+			dist[i] = enter_dist;
+		}
+	}
+
+	while(true) {
+		// Lanes past their end distance stop before stepping. Stopped lanes are left untouched,
+		// so the packet is done once a step moves no lane.
+		std::int32_t any = 0;
+
+		// Every array element is loaded once up front, a load inside std::min
+		// (which returns a reference) is a branch and keeps GCC from if-converting the loop.
+		// Unrolling is off, otherwise GCC unrolls the 4 lane loop completely before it gets to vectorize it.
+		#pragma GCC unroll 1
+		for(std::size_t i = 0; i < N; ++i) {
+			const float lx = length_x[i];
+			const float ly = length_y[i];
+			const float lz = length_z[i];
+			const float sx = scale_x[i];
+			const float sy = scale_y[i];
+			const float sz = scale_z[i];
+			const float d = dist[i];
+			const std::int32_t a = axis[i];
+			const std::int32_t run = running[i] & (d < end_dist[i]);
+			running[i] = run;
+			any |= run;
+
+			const float shortest = std::min(std::min(lx, ly), lz);
+			const std::int32_t move_x = run & (lx == shortest);
+			const std::int32_t move_y = run & (ly == shortest);
+			const std::int32_t move_z = run & (lz == shortest);
+			coord_x[i] += lane_select(move_x, step_x[i], 0);
+			coord_y[i] += lane_select(move_y, step_y[i], 0);
+			coord_z[i] += lane_select(move_z, step_z[i], 0);
+			length_x[i] = lx + lane_select(move_x, sx, 0.f);
+			length_y[i] = ly + lane_select(move_y, sy, 0.f);
+			length_z[i] = lz + lane_select(move_z, sz, 0.f);
+			dist[i] = lane_select(run, shortest, d);
+			// The axis stepped last: z over y over x, like ray_cast.
+			axis[i] = lane_select(move_x | move_y | move_z, 2 * move_z + (move_y & (move_z ^ 1)), a);
+		}
+		if(!any) break;
+
+		for(std::size_t i = 0; i < N; ++i) {
+			if(!running[i]) continue;
+			stats::count(&Stats::voxel_steps);
+			const stx::position3i coords {coord_x[i], coord_y[i], coord_z[i]};
+			if(!is_transparent(coords)) {
+				running[i] = false;
+				lost[i] = false;
+				continue;
+			}
+
+			const std::optional<Box> box = empty_box(coords);
+			if(!box) continue;
+
+			const stx::vector3f dir {rays.dir_x[i], rays.dir_y[i], rays.dir_z[i]};
+			const stx::position3i step {step_x[i], step_y[i], step_z[i]};
+			const auto [exit_dist, exit_axis, plane] = ray_exit(start, dir, step, *box);
+			if(!(exit_dist > dist[i])) continue;
+			ray_place_axis(start.x, dir.x, scale_x[i], step.x, exit_dist, exit_axis == 'x' ? std::optional{plane} : std::nullopt, coord_x[i], length_x[i]);
+			ray_place_axis(start.y, dir.y, scale_y[i], step.y, exit_dist, exit_axis == 'y' ? std::optional{plane} : std::nullopt, coord_y[i], length_y[i]);
+			ray_place_axis(start.z, dir.z, scale_z[i], step.z, exit_dist, exit_axis == 'z' ? std::optional{plane} : std::nullopt, coord_z[i], length_z[i]);
+			dist[i] = exit_dist;
+		}
+	}
+
+	std::array<Intersection, N> intersections;
+	for(std::size_t i = 0; i < N; ++i) {
+		if(rays.active[i] && lost[i]) stats::count(&Stats::lost_rays);
+		const stx::vector3f dir {rays.dir_x[i], rays.dir_y[i], rays.dir_z[i]};
+		intersections[i] = Intersection {
+			.coords = {coord_x[i], coord_y[i], coord_z[i]},
+			.point = stx::position3f{start + dir * dist[i]},
+			.normal = {
+				axis[i] == 0 ? -static_cast<float>(step_x[i]) : 0.f,
+				axis[i] == 1 ? -static_cast<float>(step_y[i]) : 0.f,
+				axis[i] == 2 ? -static_cast<float>(step_z[i]) : 0.f,
+			},
+			.depth = dist[i] / max_dist,
+			.lost = lost[i],
+		};
+	}
+	return intersections;
+}
+
+
+
+template<std::size_t N>
+std::array<Intersection, N> ray_cast_packet(const RayPacket<N> & rays, auto is_transparent, auto empty_box) {
+	return ray_cast_packet(rays, is_transparent, empty_box, std::nullopt);
+}
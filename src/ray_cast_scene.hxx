@@ -0,0 +1,18 @@
+#pragma once
+#include "ray_cast.hxx"
+#include "Scene.hxx"
+#include "Stats.hxx"
+
+// Casts a ray until it hits an opaque voxel of the scene, skipping empty blocks.
+// The ray is clipped to the scene bounds, so rays missing the scene cost no steps.
+inline Intersection ray_cast_scene(const Scene & scene, stx::vector3f start, stx::vector3f dir, float max_dist = ray_max_dist) {
+	Scene::Cursor cursor {scene};
+	const Intersection end = ray_cast(start, stx::normalized(dir), [&] (const Intersection & intersection) {
+		stats::count(&Stats::voxel_steps);
+		return voxel::is_transparent(cursor(intersection.coords.x, intersection.coords.y, intersection.coords.z));
+	}, [&] (const stx::position3i & coords) {
+		return scene.empty_box(coords);
+	}, scene.bounds(), max_dist);
+	if(end.lost) stats::count(&Stats::lost_rays);
+	return end;
+}
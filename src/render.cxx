@@ -0,0 +1,277 @@
+#include <optional>
+#include <chrono>
+#include <tuple>
+
+#include "stdxx/log.hxx"
+
+#include "render.hxx"
+#include "ray_cast.hxx"
+#include "ray_cast_packet.hxx"
+#include "ray_cast_scene.hxx"
+#include "trace_path.hxx"
+#include "render_kernel.hxx"
+#include "shading.hxx"
+#include "Tile.hxx"
+#include "Rng.hxx"
+#include "Stats.hxx"
+#include "Color.hxx"
+#include "Progress.hxx"
+
+stx::vector3f reflect(stx::vector3f normal, stx::vector3f ray) {
+	return ray - 2 * stx::dot(ray, normal) * normal;
+}
+
+
+
+namespace {
+	// Shades the end point of a ray and spawns the bounces from there.
+	// Runtime counterpart of render_kernel_hit.
+	std::tuple<float, float, float> render_hit(std::size_t rec_counter, bool loose_energy, std::size_t split, float max_dist, const Scene & scene, const Intersection & end, Rng & rng) {
+		float bounce_r = 0;
+		float bounce_g = 0;
+		float bounce_b = 0;
+
+		const Color v = voxel::to_color(scene(end.coords.x, end.coords.y, end.coords.z));
+		float brightness = direct_light(end.normal);
+
+		for(std::size_t i = 0; rec_counter > 1 && i < split; ++i) {
+			const stx::vector3f new_dir = random_hemisphere(end.normal, rng);
+			const auto [ bounce_r_comp, bounce_g_comp, bounce_b_comp ] = render_rec(rec_counter-1, true, 1, max_dist, scene, end.point, new_dir, rng);
+			bounce_r += bounce_r_comp / split;
+			bounce_g += bounce_g_comp / split;
+			bounce_b += bounce_b_comp / split;
+		}
+
+		return {
+			(v.r * (brightness + bounce_weight * bounce_r)) * (loose_energy ? (1.f - end.depth) : 1.f),
+			(v.g * (brightness + bounce_weight * bounce_g)) * (loose_energy ? (1.f - end.depth) : 1.f),
+			(v.b * (brightness + bounce_weight * bounce_b)) * (loose_energy ? (1.f - end.depth) : 1.f),
+		};
+	}
+
+
+
+	// Casts the primary rays of a tile in packets of N neighbouring pixels.
+	template<std::size_t N>
+	void render_tile_packets(const Tile & tile, const Scene & scene, stx::position3f start, std::size_t samples, float max_dist, Rng & rng, auto primary_dir, auto sample_offset, auto shade_hit, auto write_pixel) {
+		constexpr static std::uint32_t block_w = N == 4 ? 2 : 4;
+		constexpr static std::uint32_t block_h = N / block_w;
+
+		const auto is_transparent = [&] (const stx::position3i & coords) {
+			return voxel::is_transparent(scene(coords.x, coords.y, coords.z));
+		};
+		const auto empty_box = [&] (const stx::position3i & coords) {
+			return scene.empty_box(coords);
+		};
+
+		for(std::uint32_t y = tile.y_begin; y < tile.y_end; y += block_h) {
+			for(std::uint32_t x = tile.x_begin; x < tile.x_end; x += block_w) {
+				std::array<float, N> sum_r {};
+				std::array<float, N> sum_g {};
+				std::array<float, N> sum_b {};
+				std::array<float, N> sum_a {};
+				std::array<float, N> sum_sq {};
+
+				for(std::size_t sample = 0; sample < samples; ++sample) {
+					RayPacket<N> packet;
+					packet.start = stx::vector3f{start};
+					for(std::size_t i = 0; i < N; ++i) {
+						const std::uint32_t px = x + i % block_w;
+						const std::uint32_t py = y + i / block_w;
+						const stx::vector3f dir = stx::normalized(primary_dir(px + sample_offset(rng), py + sample_offset(rng)));
+						packet.dir_x[i] = dir.x;
+						packet.dir_y[i] = dir.y;
+						packet.dir_z[i] = dir.z;
+						packet.active[i] = px < tile.x_end && py < tile.y_end;
+					}
+
+					stats::count(&Stats::primary_rays, std::count(packet.active.begin(), packet.active.end(), true));
+					const std::array<Intersection, N> ends = ray_cast_packet(packet, is_transparent, empty_box, scene.bounds(), max_dist);
+
+					for(std::size_t i = 0; i < N; ++i) {
+						if(!packet.active[i]) continue;
+						const auto [r,g,b] = shade_hit(ends[i], rng);
+						sum_r[i] += r;
+						sum_g[i] += g;
+						sum_b[i] += b;
+						sum_a[i] += ends[i].lost ? 0.f : 1.f;
+						sum_sq[i] += luminance(r, g, b) * luminance(r, g, b);
+					}
+				}
+
+				for(std::size_t i = 0; i < N; ++i) {
+					const std::uint32_t px = x + i % block_w;
+					const std::uint32_t py = y + i / block_w;
+					if(px >= tile.x_end || py >= tile.y_end) continue;
+					write_pixel(px, py, sum_r[i], sum_g[i], sum_b[i], sum_a[i], sum_sq[i]);
+				}
+			}
+		}
+	}
+
+
+
+	void log_pass(std::size_t pass, std::size_t num_converged, std::size_t num_tiles, const Options & options) {
+		if(options.adaptive_threshold > 0) {
+			stx::log[stx::INFO] << "Pass " << pass << "/" << options.samples << ", " << num_converged << "/" << num_tiles << " tiles converged";
+		}
+		else {
+			stx::log[stx::INFO] << "Pass " << pass << "/" << options.samples;
+		}
+	}
+}
+
+
+
+std::tuple<float, float, float> render_rec(std::size_t rec_counter, bool loose_energy, std::size_t split, float max_dist, const Scene & scene, stx::position3f start, stx::vector3f dir, Rng & rng) {
+	if(rec_counter <= 0) return {0,0,0};
+	stats::count(&Stats::secondary_rays);
+	const Intersection end = ray_cast_scene(scene, stx::vector3f{start}, dir, max_dist);
+	return render_hit(rec_counter, loose_energy, split, max_dist, scene, end, rng);
+}
+
+
+
+void render_pass(Framebuffer & frame, const Scene & scene, const CameraRays & camera_rays, std::size_t samples, std::uint64_t pass, const Options & options, ThreadPool & pool, const std::vector<bool> & converged) {
+	const stx::position3f start = camera_rays.origin;
+	const stx::size2u resolution = frame.resolution;
+
+	const std::size_t max_bounce = options.max_bounce;
+	const std::size_t split = options.split;
+	const float max_dist = options.max_distance;
+
+	const std::vector<Tile> tiles = make_tiles(resolution, static_cast<std::uint32_t>(options.tile_size));
+	// Workers report finished tiles, a separate thread does the printing.
+	std::optional<Progress> progress;
+	if(!options.progressive && !options.quiet) progress.emplace(tiles.size(), std::chrono::seconds{1});
+
+	// A single sample keeps to the pixel corner, more samples are jittered across the pixel.
+	const auto sample_offset = [&] (Rng & rng) {
+		return options.samples > 1 ? rng.unit() : 0.f;
+	};
+
+	const RenderKernel kernel = select_render_kernel(max_bounce, split);
+
+	const auto shade_hit = [&] (const Intersection & end, Rng & rng) {
+		if(options.integrator == Integrator::path) return trace_path(scene, end, max_bounce, max_dist, rng);
+		if(kernel) return kernel(scene, end, max_dist, rng);
+		return render_hit(max_bounce, false, split, max_dist, scene, end, rng);
+	};
+
+	// Takes the sum over all samples of the pixel.
+	const auto write_pixel = [&] (std::uint32_t x, std::uint32_t y, float r, float g, float b, float a, float sum_sq) {
+		frame.add(x, y, r, g, b, a, sum_sq, static_cast<std::uint32_t>(samples));
+	};
+
+	std::vector<Stats> worker_stats(pool.size());
+
+	pool.run(tiles.size(), [&] (std::size_t t, std::size_t worker) {
+		if(!converged.empty() && converged[t]) return;
+		const Tile & tile = tiles[t];
+		stats::current = &worker_stats[worker];
+		Rng rng {options.seed, pass * tiles.size() + t};
+		switch(options.packet_size) {
+			case 4:  render_tile_packets<4>(tile, scene, start, samples, max_dist, rng, camera_rays, sample_offset, shade_hit, write_pixel); break;
+			case 8:  render_tile_packets<8>(tile, scene, start, samples, max_dist, rng, camera_rays, sample_offset, shade_hit, write_pixel); break;
+			case 16: render_tile_packets<16>(tile, scene, start, samples, max_dist, rng, camera_rays, sample_offset, shade_hit, write_pixel); break;
+			default:
+				for(std::uint32_t y = tile.y_begin; y < tile.y_end; ++y){
+					for(std::uint32_t x = tile.x_begin; x < tile.x_end; ++x){
+						float sum_r = 0;
+						float sum_g = 0;
+						float sum_b = 0;
+						float sum_a = 0;
+						float sum_sq = 0;
+						for(std::size_t sample = 0; sample < samples; ++sample) {
+							const stx::vector3f dir = camera_rays(x + sample_offset(rng), y + sample_offset(rng));
+							stats::count(&Stats::primary_rays);
+							const Intersection end = ray_cast_scene(scene, stx::vector3f{start}, dir, max_dist);
+							const auto [r,g,b] = shade_hit(end, rng);
+							sum_r += r;
+							sum_g += g;
+							sum_b += b;
+							sum_a += end.lost ? 0.f : 1.f;
+							sum_sq += luminance(r, g, b) * luminance(r, g, b);
+						}
+						write_pixel(x, y, sum_r, sum_g, sum_b, sum_a, sum_sq);
+					}
+				}
+		}
+
+		stats::current = nullptr;
+
+		if(progress) {
+			const std::uint64_t pixels = std::uint64_t{tile.x_end - tile.x_begin} * (tile.y_end - tile.y_begin);
+			progress->tile_done(pixels * samples);
+		}
+	});
+	progress.reset();
+
+	for(const Stats & stats : worker_stats) {
+		frame.stats += stats;
+	}
+}
+
+
+
+Framebuffer render(const stx::size2u resolution, const Scene & scene, const Camera & camera, const Options & options, ThreadPool & pool) {
+	if(options.adaptive_threshold > 0 || options.time_budget > 0) {
+		Options passes = options;
+		passes.progressive = true;
+		return render_progressive(resolution, scene, camera, passes, pool, [] (const Framebuffer &, std::size_t) {});
+	}
+	Framebuffer frame {resolution};
+	render_pass(frame, scene, CameraRays{camera, resolution}, options.samples, 0, options, pool);
+	return frame;
+}
+
+
+
+Framebuffer render_progressive(const stx::size2u resolution, const Scene & scene, const Camera & camera, const Options & options, ThreadPool & pool, const std::function<void(const Framebuffer &, std::size_t passes)> & flush) {
+	using clock = std::chrono::steady_clock;
+	const std::chrono::duration<double> time_budget {options.time_budget};
+	const std::chrono::duration<double> flush_interval {options.flush_interval};
+
+	Framebuffer frame {resolution};
+	const CameraRays camera_rays {camera, resolution};
+	const clock::time_point time_start = clock::now();
+	clock::time_point last_flush = time_start;
+	std::size_t passes_since_flush = 0;
+
+	const std::vector<Tile> tiles = make_tiles(resolution, static_cast<std::uint32_t>(options.tile_size));
+	std::vector<bool> converged(tiles.size(), false);
+	std::size_t num_converged = 0;
+
+	std::size_t pass = 0;
+	while(pass < options.samples) {
+		render_pass(frame, scene, camera_rays, 1, pass, options, pool, converged);
+		++pass;
+		++passes_since_flush;
+
+		if(options.adaptive_threshold > 0 && pass >= options.adaptive_min_samples) {
+			for(std::size_t t = 0; t < tiles.size(); ++t) {
+				if(converged[t] || frame.error(tiles[t]) > options.adaptive_threshold) continue;
+				converged[t] = true;
+				++num_converged;
+			}
+			if(num_converged == tiles.size()) break;
+		}
+
+		const clock::time_point now = clock::now();
+		if(options.time_budget > 0 && now - time_start >= time_budget) break;
+		if(pass == options.samples) break;
+
+		const bool flush_time = options.flush_interval > 0 && now - last_flush >= flush_interval;
+		const bool flush_passes = options.flush_passes > 0 && passes_since_flush >= options.flush_passes;
+		if(pass == 1 || flush_time || flush_passes) {
+			log_pass(pass, num_converged, tiles.size(), options);
+			flush(frame, pass);
+			last_flush = clock::now();
+			passes_since_flush = 0;
+		}
+	}
+
+	log_pass(pass, num_converged, tiles.size(), options);
+	flush(frame, pass);
+	return frame;
+}
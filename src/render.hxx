@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <tuple>
+#include <functional>
+#include <vector>
+#include "stdxx/vector.hxx"
+#include "Scene.hxx"
+#include "Camera.hxx"
+#include "CameraRays.hxx"
+#include "Framebuffer.hxx"
+#include "Options.hxx"
+#include "ThreadPool.hxx"
+#include "Rng.hxx"
+
+// Recursive integrator with runtime settings, see render_kernel for the compiled ones.
+// The first hit spawns split bounces, each continuing as a single path losing energy with depth
+// until rec_counter runs out.
+std::tuple<float, float, float> render_rec(std::size_t rec_counter, bool loose_energy, std::size_t split, float max_dist, const Scene & scene, stx::position3f start, stx::vector3f dir, Rng & rng);
+
+// Adds samples samples to every pixel of frame.
+// pass selects the random streams, so every pass draws new samples.
+// converged[t] skips tile t of make_tiles(resolution, options.tile_size), an empty vector renders every tile.
+void render_pass(Framebuffer & frame, const Scene & scene, const CameraRays & camera_rays, std::size_t samples, std::uint64_t pass, const Options & options, ThreadPool & pool, const std::vector<bool> & converged = {});
+
+// Renders options.samples samples per pixel in a single pass.
+// With options.adaptive_threshold or options.time_budget set it renders progressively without flushing instead.
+Framebuffer render(const stx::size2u resolution, const Scene & scene, const Camera & camera, const Options & options, ThreadPool & pool);
+
+// Renders one sample per pixel and pass until options.samples samples or options.time_budget is reached.
+// flush receives the frame after the first pass, whenever a flush interval has passed and after the last pass.
+// With options.adaptive_threshold set, tiles whose error (see Framebuffer::error) falls below it
+// after options.adaptive_min_samples passes get no further samples. It stops once every tile has converged.
+Framebuffer render_progressive(const stx::size2u resolution, const Scene & scene, const Camera & camera, const Options & options, ThreadPool & pool, const std::function<void(const Framebuffer &, std::size_t passes)> & flush);
@@ -0,0 +1,30 @@
+#include "render_kernel.hxx"
+
+namespace {
+	template<std::size_t MaxBounce>
+	RenderKernel select_split(std::size_t split) {
+		switch (split) {
+			case 1: return &render_kernel_hit<MaxBounce, 1, false>;
+			case 2: return &render_kernel_hit<MaxBounce, 2, false>;
+			case 3: return &render_kernel_hit<MaxBounce, 3, false>;
+			case 4: return &render_kernel_hit<MaxBounce, 4, false>;
+			default: return nullptr;
+		}
+	}
+}
+
+
+
+RenderKernel select_render_kernel(std::size_t max_bounce, std::size_t split) {
+	switch (max_bounce) {
+		case 1: return select_split<1>(split);
+		case 2: return select_split<2>(split);
+		case 3: return select_split<3>(split);
+		case 4: return select_split<4>(split);
+		case 5: return select_split<5>(split);
+		case 6: return select_split<6>(split);
+		case 7: return select_split<7>(split);
+		case 8: return select_split<8>(split);
+		default: return nullptr;
+	}
+}
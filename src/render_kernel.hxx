@@ -0,0 +1,68 @@
+#pragma once
+#include <tuple>
+#include "stdxx/vector.hxx"
+#include "Scene.hxx"
+#include "Intersection.hxx"
+#include "ray_cast_scene.hxx"
+#include "shading.hxx"
+#include "Stats.hxx"
+#include "Rng.hxx"
+
+// Recursive integrator with its settings fixed at compile time, so the bounce chain unrolls.
+// A hit spawns Split bounces, every bounce after that continues as a single path that loses
+// energy with depth. Same tree and shading as render_rec(max_bounce, LooseEnergy, split, max_dist, ...).
+template<std::size_t MaxBounce, std::size_t Split, bool LooseEnergy>
+std::tuple<float, float, float> render_kernel_hit(const Scene & scene, const Intersection & end, float max_dist, Rng & rng);
+
+
+
+template<std::size_t MaxBounce, std::size_t Split, bool LooseEnergy>
+std::tuple<float, float, float> render_kernel(const Scene & scene, stx::position3f start, stx::vector3f dir, float max_dist, Rng & rng) {
+	if constexpr (MaxBounce == 0) {
+		return {0,0,0};
+	}
+	else {
+		stats::count(&Stats::secondary_rays);
+		const Intersection end = ray_cast_scene(scene, stx::vector3f{start}, dir, max_dist);
+		return render_kernel_hit<MaxBounce, Split, LooseEnergy>(scene, end, max_dist, rng);
+	}
+}
+
+
+
+template<std::size_t MaxBounce, std::size_t Split, bool LooseEnergy>
+std::tuple<float, float, float> render_kernel_hit(const Scene & scene, const Intersection & end, float max_dist, Rng & rng) {
+	float bounce_r = 0;
+	float bounce_g = 0;
+	float bounce_b = 0;
+
+	const Color v = voxel::to_color(scene(end.coords.x, end.coords.y, end.coords.z));
+	const float brightness = direct_light(end.normal);
+
+	// The last level has nothing left to bounce into.
+	if constexpr (MaxBounce > 1) {
+		for(std::size_t i = 0; i < Split; ++i) {
+			const stx::vector3f new_dir = random_hemisphere(end.normal, rng);
+			const auto [ bounce_r_comp, bounce_g_comp, bounce_b_comp ] = render_kernel<MaxBounce - 1, 1, true>(scene, end.point, new_dir, max_dist, rng);
+			bounce_r += bounce_r_comp / Split;
+			bounce_g += bounce_g_comp / Split;
+			bounce_b += bounce_b_comp / Split;
+		}
+	}
+
+	const float energy = LooseEnergy ? (1.f - end.depth) : 1.f;
+	return {
+		(v.r * (brightness + bounce_weight * bounce_r)) * energy,
+		(v.g * (brightness + bounce_weight * bounce_g)) * energy,
+		(v.b * (brightness + bounce_weight * bounce_b)) * energy,
+	};
+}
+
+
+
+// Shades a primary hit.
+using RenderKernel = std::tuple<float, float, float> (*)(const Scene & scene, const Intersection & end, float max_dist, Rng & rng);
+
+// Instantiated kernel for max_bounce 1 to 8 and split 1 to 4.
+// Returns nullptr for other settings, render_rec covers those at runtime.
+RenderKernel select_render_kernel(std::size_t max_bounce, std::size_t split);
@@ -0,0 +1,26 @@
+#pragma once
+#include <algorithm>
+#include "stdxx/vector.hxx"
+#include "Rng.hxx"
+
+// Share of the light arriving from a bounce that a surface passes on.
+constexpr inline float bounce_weight = 0.5f;
+
+
+
+// Light from the fixed sun direction with a small ambient term.
+inline float direct_light(stx::vector3f normal) {
+	return std::clamp(stx::dot(normal, stx::normalized(stx::vector3f{0,-0.5f,1})), 0.1f, 1.f);
+}
+
+
+
+// Random unit vector in the hemisphere around normal.
+inline stx::vector3f random_hemisphere(stx::vector3f normal, Rng & rng) {
+	const float dx = rng.unit() * 2.f - 1.f;
+	const float dy = rng.unit() * 2.f - 1.f;
+	const float dz = rng.unit() * 2.f - 1.f;
+	const stx::vector3f rand_dir{dx, dy, dz};
+	const stx::vector3f hemi_dir = stx::dot(normal, rand_dir) >= 0 ? rand_dir : -rand_dir;
+	return stx::normalized(hemi_dir);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <algorithm>
+#include <string_view>
+
+// Maps linear radiance to [0, 1] for 8 bit outputs.
+// Float outputs (pfm, exr) are written linear and skip this.
+enum class Tonemap {
+	clamp,    // cuts everything above 1, the look of earlier versions
+	reinhard, // x / (1 + x)
+	aces,     // Narkowicz's fit of the ACES filmic curve
+};
+
+
+
+inline float tonemap(Tonemap op, float x) {
+	switch (op) {
+		case Tonemap::clamp: break;
+		case Tonemap::reinhard: x = x / (1.f + x); break;
+		case Tonemap::aces: x = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f); break;
+	}
+	return std::clamp(x, 0.f, 1.f);
+}
+
+
+
+inline std::string_view to_string(Tonemap op) {
+	switch (op) {
+		case Tonemap::clamp: return "clamp";
+		case Tonemap::reinhard: return "reinhard";
+		case Tonemap::aces: return "aces";
+	}
+	return "";
+}
@@ -0,0 +1,58 @@
+#include "trace_path.hxx"
+#include "ray_cast_scene.hxx"
+#include "shading.hxx"
+
+namespace {
+	constexpr std::size_t roulette_start = 2;
+	constexpr float max_survival = 0.95f;
+}
+
+
+
+std::tuple<float, float, float> trace_path(const Scene & scene, const Intersection & first_hit, std::size_t max_bounce, float max_dist, Rng & rng) {
+	float r = 0;
+	float g = 0;
+	float b = 0;
+
+	float throughput_r = 1;
+	float throughput_g = 1;
+	float throughput_b = 1;
+
+	Intersection end = first_hit;
+	for(std::size_t bounce = 0; bounce < max_bounce; ++bounce) {
+		if(end.lost) break;
+
+		const Color v = voxel::to_color(scene(end.coords.x, end.coords.y, end.coords.z));
+		const float energy = bounce == 0 ? 1.f : 1.f - end.depth;
+		throughput_r *= v.r * energy;
+		throughput_g *= v.g * energy;
+		throughput_b *= v.b * energy;
+
+		const float light = direct_light(end.normal);
+		r += throughput_r * light;
+		g += throughput_g * light;
+		b += throughput_b * light;
+
+		throughput_r *= bounce_weight;
+		throughput_g *= bounce_weight;
+		throughput_b *= bounce_weight;
+
+		if(bounce + 1 == max_bounce) break;
+
+		if(bounce >= roulette_start) {
+			const float survival = std::min(std::max({throughput_r, throughput_g, throughput_b}), max_survival);
+			if(rng.unit() >= survival) {
+				stats::count(&Stats::early_terminations);
+				break;
+			}
+			throughput_r /= survival;
+			throughput_g /= survival;
+			throughput_b /= survival;
+		}
+
+		stats::count(&Stats::secondary_rays);
+		end = ray_cast_scene(scene, stx::vector3f{end.point}, random_hemisphere(end.normal, rng), max_dist);
+	}
+
+	return {r, g, b};
+}
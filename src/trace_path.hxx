@@ -0,0 +1,10 @@
+#pragma once
+#include <tuple>
+#include "Scene.hxx"
+#include "Intersection.hxx"
+#include "Rng.hxx"
+
+// Iterative path tracer following one path per sample.
+// Every bounce adds its direct light weighted by the throughput gathered along the path so far.
+// From the third bounce on paths are terminated by Russian roulette.
+std::tuple<float, float, float> trace_path(const Scene & scene, const Intersection & first_hit, std::size_t max_bounce, float max_dist, Rng & rng);
@@ -0,0 +1,204 @@
+#include "write_image.hxx"
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+#include "stb/stb_image_write.h"
+
+namespace {
+	void write_png(const std::filesystem::path & path, stx::size2u resolution, const std::vector<std::uint8_t> & rgba) {
+		const int ok = stbi_write_png(path.c_str(), resolution.x, resolution.y, 4, rgba.data(), resolution.x * 4);
+		if(!ok) throw std::runtime_error{"Cannot write " + path.string()};
+	}
+
+
+
+	void write_raw(const std::filesystem::path & path, const std::string & header, const std::vector<std::uint8_t> & data) {
+		std::ofstream file {path, std::ios::binary};
+		file << header;
+		file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+		if(!file) throw std::runtime_error{"Cannot write " + path.string()};
+	}
+
+
+
+	// Little endian, like every platform we build for.
+	template<typename T>
+	void put(std::vector<std::uint8_t> & out, T value) {
+		const std::size_t at = out.size();
+		out.resize(at + sizeof(T));
+		std::memcpy(out.data() + at, &value, sizeof(T));
+	}
+
+
+
+	void put_string(std::vector<std::uint8_t> & out, std::string_view str) {
+		out.insert(out.end(), str.begin(), str.end());
+		out.push_back(0);
+	}
+
+
+
+	// Portable float map, the bottom row comes first. A negative scale marks little endian data.
+	std::vector<std::uint8_t> encode_pfm(stx::size2u resolution, const std::vector<float> & rgba) {
+		std::vector<std::uint8_t> out;
+		for(std::uint32_t y = resolution.y; y-- > 0;) {
+			for(std::uint32_t x = 0; x < resolution.x; ++x) {
+				const std::size_t i = std::size_t{y} * resolution.x + x;
+				put(out, rgba[4 * i + 0]);
+				put(out, rgba[4 * i + 1]);
+				put(out, rgba[4 * i + 2]);
+			}
+		}
+		return out;
+	}
+
+
+
+	// Single part scanline OpenEXR with 32 bit float channels and no compression.
+	// Every chunk holds one scanline with the channels in alphabetical order.
+	std::vector<std::uint8_t> encode_exr(stx::size2u resolution, const std::vector<float> & rgba) {
+		constexpr std::int32_t pixel_type_float = 2;
+		const std::int32_t max_x = static_cast<std::int32_t>(resolution.x) - 1;
+		const std::int32_t max_y = static_cast<std::int32_t>(resolution.y) - 1;
+
+		std::vector<std::uint8_t> out;
+		put(out, std::uint32_t{20000630});
+		put(out, std::uint32_t{2});
+
+		put_string(out, "channels");
+		put_string(out, "chlist");
+		put(out, std::int32_t{4 * 18 + 1});
+		for(const char * channel : {"A", "B", "G", "R"}) {
+			put_string(out, channel);
+			put(out, pixel_type_float);
+			put(out, std::uint32_t{0}); // pLinear and reserved
+			put(out, std::int32_t{1});
+			put(out, std::int32_t{1});
+		}
+		put(out, std::uint8_t{0});
+
+		put_string(out, "compression");
+		put_string(out, "compression");
+		put(out, std::int32_t{1});
+		put(out, std::uint8_t{0});
+
+		for(const char * window : {"dataWindow", "displayWindow"}) {
+			put_string(out, window);
+			put_string(out, "box2i");
+			put(out, std::int32_t{16});
+			put(out, std::int32_t{0});
+			put(out, std::int32_t{0});
+			put(out, max_x);
+			put(out, max_y);
+		}
+
+		put_string(out, "lineOrder");
+		put_string(out, "lineOrder");
+		put(out, std::int32_t{1});
+		put(out, std::uint8_t{0});
+
+		put_string(out, "pixelAspectRatio");
+		put_string(out, "float");
+		put(out, std::int32_t{4});
+		put(out, 1.f);
+
+		put_string(out, "screenWindowCenter");
+		put_string(out, "v2f");
+		put(out, std::int32_t{8});
+		put(out, 0.f);
+		put(out, 0.f);
+
+		put_string(out, "screenWindowWidth");
+		put_string(out, "float");
+		put(out, std::int32_t{4});
+		put(out, 1.f);
+
+		put(out, std::uint8_t{0});
+
+		const std::uint64_t line_size = std::uint64_t{resolution.x} * 4 * sizeof(float);
+		const std::uint64_t table_end = out.size() + std::uint64_t{resolution.y} * sizeof(std::uint64_t);
+		for(std::uint64_t y = 0; y < resolution.y; ++y) {
+			put(out, table_end + y * (8 + line_size));
+		}
+
+		for(std::uint32_t y = 0; y < resolution.y; ++y) {
+			put(out, static_cast<std::int32_t>(y));
+			put(out, static_cast<std::int32_t>(line_size));
+			for(const std::size_t c : {3, 2, 1, 0}) {
+				for(std::uint32_t x = 0; x < resolution.x; ++x) {
+					put(out, rgba[4 * (std::size_t{y} * resolution.x + x) + c]);
+				}
+			}
+		}
+		return out;
+	}
+
+
+
+	std::vector<std::uint8_t> drop_alpha(const std::vector<std::uint8_t> & rgba) {
+		std::vector<std::uint8_t> rgb(rgba.size() / 4 * 3);
+		for(std::size_t i = 0; i < rgba.size() / 4; ++i) {
+			rgb[3 * i + 0] = rgba[4 * i + 0];
+			rgb[3 * i + 1] = rgba[4 * i + 1];
+			rgb[3 * i + 2] = rgba[4 * i + 2];
+		}
+		return rgb;
+	}
+}
+
+
+
+ImageFormat image_format(const std::filesystem::path & path) {
+	const std::string extension = path.extension().string();
+	if(extension == ".png") return ImageFormat::png;
+	if(extension == ".ppm") return ImageFormat::ppm;
+	if(extension == ".pam") return ImageFormat::pam;
+	if(extension == ".rgba") return ImageFormat::rgba;
+	if(extension == ".pfm") return ImageFormat::pfm;
+	if(extension == ".exr") return ImageFormat::exr;
+	throw std::runtime_error{"Unsupported output format \"" + extension + "\""};
+}
+
+
+
+std::string_view to_string(ImageFormat format) {
+	switch (format) {
+		case ImageFormat::png: return "PNG";
+		case ImageFormat::ppm: return "PPM";
+		case ImageFormat::pam: return "PAM";
+		case ImageFormat::rgba: return "RGBA";
+		case ImageFormat::pfm: return "PFM";
+		case ImageFormat::exr: return "EXR";
+	}
+	return "";
+}
+
+
+
+void write_image(const std::filesystem::path & path, const Framebuffer & frame, Tonemap op, float exposure) {
+	const stx::size2u resolution = frame.resolution;
+	const std::string size = std::to_string(resolution.x) + " " + std::to_string(resolution.y);
+	switch (image_format(path)) {
+		case ImageFormat::png:
+			write_png(path, resolution, frame.to_rgba8(op, exposure));
+			break;
+		case ImageFormat::ppm:
+			write_raw(path, "P6\n" + size + "\n255\n", drop_alpha(frame.to_rgba8(op, exposure)));
+			break;
+		case ImageFormat::pam:
+			write_raw(path,
+				"P7\nWIDTH " + std::to_string(resolution.x) +
+				"\nHEIGHT " + std::to_string(resolution.y) +
+				"\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", frame.to_rgba8(op, exposure));
+			break;
+		case ImageFormat::rgba:
+			write_raw(path, "", frame.to_rgba8(op, exposure));
+			break;
+		case ImageFormat::pfm:
+			write_raw(path, "PF\n" + size + "\n-1.0\n", encode_pfm(resolution, frame.to_rgba32f()));
+			break;
+		case ImageFormat::exr:
+			write_raw(path, "", encode_exr(resolution, frame.to_rgba32f()));
+			break;
+	}
+}
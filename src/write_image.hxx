@@ -0,0 +1,23 @@
+#pragma once
+#include <filesystem>
+#include <string_view>
+#include "Framebuffer.hxx"
+
+// Output file formats, chosen by file extension.
+// ppm, pam and rgba are written uncompressed for tools that re-encode anyway.
+// pfm and exr keep the linear float data of the framebuffer.
+enum class ImageFormat {
+	png,  // .png  RGBA8, deflated by stb
+	ppm,  // .ppm  binary P6, RGB8
+	pam,  // .pam  P7 RGB_ALPHA, RGBA8
+	rgba, // .rgba headerless RGBA8 rows, top to bottom
+	pfm,  // .pfm  RGB float, rows bottom to top
+	exr,  // .exr  RGBA float scanlines, uncompressed
+};
+
+// Throws if the extension is not a supported format.
+ImageFormat image_format(const std::filesystem::path & path);
+std::string_view to_string(ImageFormat format);
+
+// 8 bit formats are exposed and tonemapped, float formats are written as they are.
+void write_image(const std::filesystem::path & path, const Framebuffer & frame, Tonemap op = Tonemap::clamp, float exposure = 1.f);